@@ -5,76 +5,1785 @@
 #include <sys/stat.h>  // for mkdir
 #include <unistd.h>    // for write/flush ordering mocks
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include "node_arena.h"
+#include "sort_kernels.h"
+
 using namespace std;
 using namespace std::chrono;
 
 // ====== Fake Persistent Memory Metrics (emulated PCM) ======
 static uint64_t Nw = 0, Nclf = 0, Nmf = 0;
-inline void pcm_write() { ++Nw; }
-inline void pcm_flush() { ++Nclf; } // emulated cache line flush
-inline void pcm_fence() { ++Nmf; }  // emulated memory fence / durability barrier
+
+// Optional injected persistence latency (0 = off): a flushed line becomes
+// durable pm_write_ns after the flush is issued, flushes overlap freely, and
+// a fence spins until every line flushed so far is durable.
+static uint64_t pm_write_ns = 0;
+static steady_clock::time_point flushes_durable_at;
+inline void pm_spin_until(steady_clock::time_point t) {
+    while (steady_clock::now() < t) {} // busy-wait: sleeps are far too coarse
+}
+
+inline void pcm_write(uint64_t words = 1) { Nw += words; }
+inline void pcm_flush() { // emulated cache line flush
+    ++Nclf;
+    if (pm_write_ns) flushes_durable_at = steady_clock::now() + nanoseconds(pm_write_ns);
+}
+
+// Relaxed persistence modes (EpochPersist, PipelinedPersist below) take
+// over line flushes and elide the per-op fence while installed.
+class EpochPersist;
+class PipelinedPersist;
+static EpochPersist *epoch_persist = nullptr;
+static PipelinedPersist *pipelined_persist = nullptr;
+void epoch_record(uintptr_t line);
+void pipelined_flush(uintptr_t line);
+
+inline void pcm_drain() { // the fence itself: wait for every issued flush
+    ++Nmf;
+    if (pm_write_ns) pm_spin_until(flushes_durable_at);
+}
+inline void pcm_fence() { // emulated memory fence / durability barrier
+    if (epoch_persist || pipelined_persist) return;
+    pcm_drain();
+}
+
+// Flush every cache line overlapping [p, p + bytes), by real address.
+static const uintptr_t LINE = 64;
+inline void pcm_flush_range(const void *p, size_t bytes) {
+    uintptr_t a = (uintptr_t)p;
+    for (uintptr_t l = a / LINE; l <= (a + bytes - 1) / LINE; l++) {
+        if (epoch_persist)          epoch_record(l);
+        else if (pipelined_persist) pipelined_flush(l);
+        else                        pcm_flush();
+    }
+}
+
+// ====== Buffered durable linearizability: epoch persistence ======
+// Installing an EpochPersist relaxes every variant at once: an op is
+// linearized when it returns but durable only when its epoch closes.
+// An epoch closes every max_ops ops or max_us microseconds (0 = no limit);
+// closing flushes each distinct dirty line once and issues one fence.
+// Lines are deduplicated as they are recorded: each carries the id of the
+// last epoch that recorded it, so a line joins the dirty list once per
+// epoch and closing is a straight walk. The ops bound is checked in
+// op_done(). The time bound is checked there too, reading the clock every
+// CLOCK_EVERY ops, and backed by a timer thread so it holds when the writer
+// goes idle or the timer gets the CPU first: at the deadline the timer
+// raises a flag that the next op_done() acts on, and if the writer is
+// between ops (m free) it closes the epoch itself. With a time bound, ops
+// are bracketed by op_begin()/op_done() so an epoch only ever closes at an
+// op boundary.
+// The model assumes dirty lines reach PM only at epoch closes (hardware
+// would need versioned lines or an undo log against mid-epoch eviction),
+// so PM always holds the effect of exactly the first durable_ops ops -- a
+// consistent prefix. With keep_image the closed lines are also copied
+// aside, and restore() rebuilds memory as a crash would.
+class EpochPersist {
+public:
+    uint64_t ops = 0, durable_ops = 0, epochs = 0, max_epoch_ops = 0;
+    double max_epoch_us = 0; // epoch open to its fence completing
+
+    EpochPersist(uint64_t max_ops, uint64_t max_us, bool keep_image = false)
+        : max_ops(max_ops), max_us(max_us), keep_image(keep_image), stamps(1 << 12) {
+        epoch_persist = this;
+        epoch_start = steady_clock::now();
+        epoch_start_ns = epoch_start.time_since_epoch().count();
+        if (max_us) timer = thread([this] { run_timer(); });
+    }
+    ~EpochPersist() {
+        if (timer.joinable()) {
+            {
+                lock_guard<mutex> g(timer_m);
+                stopping = true;
+            }
+            wake.notify_one();
+            timer.join();
+        }
+        close();
+        epoch_persist = nullptr;
+    }
+    EpochPersist(const EpochPersist &) = delete;
+    EpochPersist &operator=(const EpochPersist &) = delete;
+
+    void record(uintptr_t line) {
+        if (stamp(line)) dirty.push_back(line);
+    }
+
+    void op_begin() {
+        if (max_us) m.lock();
+    }
+
+    void op_done() {
+        ops++;
+        if ((max_ops && ops - durable_ops >= max_ops) ||
+            (max_us && (close_due.load(memory_order_relaxed) ||
+                        (ops % CLOCK_EVERY == 0 && steady_clock::now() - epoch_start >= microseconds(max_us)))))
+            close_locked();
+        if (max_us) m.unlock();
+    }
+
+    void close() {
+        if (max_us) {
+            lock_guard<mutex> g(m);
+            close_locked();
+        } else {
+            close_locked();
+        }
+    }
+
+    // Copy into dst what PM holds for [orig, orig + bytes); lines never
+    // persisted keep dst's contents (the state before the epoch mode).
+    void restore(void *dst, const void *orig, size_t bytes) const {
+        uintptr_t a = (uintptr_t)orig;
+        for (uintptr_t l = a / LINE; l <= (a + bytes - 1) / LINE; l++) {
+            auto it = image.find(l);
+            if (it == image.end()) continue;
+            uintptr_t lo = max(a, l * LINE), hi = min(a + bytes, (l + 1) * LINE);
+            memcpy((char *)dst + (lo - a), it->second.data() + (lo - l * LINE), hi - lo);
+        }
+    }
+
+private:
+    static const uint64_t CLOCK_EVERY = 64;
+    uint64_t max_ops, max_us;
+    bool keep_image;
+    vector<uintptr_t> dirty;
+    unordered_map<uintptr_t, array<unsigned char, LINE>> image;
+    steady_clock::time_point epoch_start;
+
+    // Line -> id of the last epoch that recorded it (open addressing,
+    // line 0 = empty slot, kept at most half full).
+    struct Stamp { uintptr_t line; uint64_t epoch; };
+    vector<Stamp> stamps;
+    size_t n_stamped = 0;
+    uint64_t epoch_id = 1;
+
+    // Timer state. m brackets each op and each close while the timer runs;
+    // timer_m only guards `stopping`.
+    mutex m, timer_m;
+    condition_variable wake;
+    thread timer;
+    atomic<bool> close_due{false};
+    atomic<steady_clock::rep> epoch_start_ns{0};
+    bool stopping = false;
+
+    // True the first time `line` is recorded in the current epoch.
+    bool stamp(uintptr_t line) {
+        const size_t mask = stamps.size() - 1;
+        for (size_t i = (line * 0x9E3779B97F4A7C15ULL) >> 20 & mask;; i = (i + 1) & mask) {
+            Stamp &st = stamps[i];
+            if (st.line == line) {
+                if (st.epoch == epoch_id) return false;
+                st.epoch = epoch_id;
+                return true;
+            }
+            if (st.line == 0) {
+                st = {line, epoch_id};
+                if (++n_stamped * 2 > stamps.size()) grow_stamps();
+                return true;
+            }
+        }
+    }
+
+    void grow_stamps() {
+        vector<Stamp> old(stamps.size() * 2);
+        old.swap(stamps);
+        const size_t mask = stamps.size() - 1;
+        for (const Stamp &st : old) {
+            if (!st.line) continue;
+            size_t i = (st.line * 0x9E3779B97F4A7C15ULL) >> 20 & mask;
+            while (stamps[i].line) i = (i + 1) & mask;
+            stamps[i] = st;
+        }
+    }
+
+    void close_locked() {
+        for (uintptr_t l : dirty) {
+            pcm_flush();
+            if (keep_image) memcpy(image[l].data(), (const void *)(l * LINE), LINE);
+        }
+        if (!dirty.empty()) pcm_drain();
+        const auto now = steady_clock::now();
+        if (ops > durable_ops) {
+            epochs++;
+            max_epoch_ops = max(max_epoch_ops, ops - durable_ops);
+            max_epoch_us = max(max_epoch_us, duration<double, micro>(now - epoch_start).count());
+        }
+        durable_ops = ops;
+        dirty.clear();
+        epoch_id++;
+        epoch_start = now;
+        close_due.store(false, memory_order_relaxed);
+        epoch_start_ns.store(now.time_since_epoch().count(), memory_order_release);
+    }
+
+    // Sleeps until the open epoch's deadline, then raises close_due for an
+    // active writer (its next op_done() closes) and closes directly if the
+    // writer is idle. While an op is in flight past the deadline it yields,
+    // so a writer preempted inside its op gets the CPU back to finish it.
+    void run_timer() {
+        for (;;) {
+            const steady_clock::rep start = epoch_start_ns.load(memory_order_acquire);
+            const auto deadline = steady_clock::time_point(steady_clock::duration(start)) + microseconds(max_us);
+            {
+                unique_lock<mutex> g(timer_m);
+                if (wake.wait_until(g, deadline, [&] { return stopping; })) return;
+            }
+            if (epoch_start_ns.load(memory_order_acquire) != start) continue; // closed meanwhile
+            close_due.store(true, memory_order_relaxed);
+            if (m.try_lock()) {
+                if (close_due.load(memory_order_relaxed)) close_locked();
+                m.unlock();
+            } else {
+                this_thread::yield();
+            }
+        }
+    }
+};
+
+void epoch_record(uintptr_t line) { epoch_persist->record(line); }
+
+// ====== Pipelined persistence: flush at store, fence on demand ======
+// With a PipelinedPersist installed, each line is flushed as soon as the op
+// stores it (the write to PM starts right away) but the op's fence is
+// deferred. op_done() hands back a completion token; wait(token) is the
+// caller's durability point and issues the fence only if that op is not
+// already covered by an earlier one. Ordering dependencies are kept: an op
+// that re-flushes a line whose previous flush is still unfenced (e.g. the
+// header of a leaf the last op also touched) fences first, so successive
+// states of a line become durable in order. Ops on different lines overlap
+// their write latency.
+class PipelinedPersist {
+public:
+    using Token = uint64_t;
+    uint64_t dependency_fences = 0;
+
+    PipelinedPersist() { pipelined_persist = this; }
+    ~PipelinedPersist() {
+        fence();
+        pipelined_persist = nullptr;
+    }
+    PipelinedPersist(const PipelinedPersist &) = delete;
+    PipelinedPersist &operator=(const PipelinedPersist &) = delete;
+
+    void flush(uintptr_t line) {
+        if (pending.count(line)) {
+            dependency_fences++;
+            fence();
+        }
+        pending.insert(line);
+        pcm_flush();
+    }
+
+    Token op_done() { return ++ops; }
+
+    bool durable(Token t) const { return t <= fenced; }
+
+    void wait(Token t) {
+        if (!durable(t)) fence();
+    }
+
+private:
+    Token ops = 0, fenced = 0;
+    unordered_set<uintptr_t> pending; // lines flushed since the last fence
+
+    void fence() {
+        if (!pending.empty()) pcm_drain();
+        pending.clear();
+        fenced = ops;
+    }
+};
+
+void pipelined_flush(uintptr_t line) { pipelined_persist->flush(line); }
+
+// ====== Key types ======
+// Leaves and the tree are templated on key type; a key costs one word write
+// per 8 bytes, and key_route() maps a key onto a leaf index.
+struct Key128 {
+    uint64_t hi = 0, lo = 0;
+    bool operator==(const Key128 &o) const { return hi == o.hi && lo == o.lo; }
+    bool operator<(const Key128 &o)  const { return hi < o.hi || (hi == o.hi && lo < o.lo); }
+};
+
+// Fixed 16-byte string key, compared bytewise (memcmp order).
+struct FixedStr16 {
+    char b[16] = {};
+    bool operator==(const FixedStr16 &o) const { return memcmp(b, o.b, 16) == 0; }
+    bool operator<(const FixedStr16 &o)  const { return memcmp(b, o.b, 16) < 0; }
+};
+
+template<typename Key>
+constexpr uint64_t key_words() { return (sizeof(Key) + 7) / 8; }
+
+inline uint64_t key_route(uint32_t k)          { return k; }
+inline uint64_t key_route(uint64_t k)          { return k; }
+inline uint64_t key_route(const Key128 &k)     { return k.hi ^ k.lo; }
+inline uint64_t key_route(const FixedStr16 &k) { uint64_t w; memcpy(&w, k.b + 8, 8); return w; }
+
+// Multiply-shift leaf routing: scramble the route word with a Fibonacci
+// multiply, then scale it onto [0, nleaves) with the high half of a 64x64
+// product. Two multiplies instead of a 64-bit division.
+inline size_t leaf_route(uint64_t r, size_t nleaves) {
+    return (size_t)(((unsigned __int128)(r * 0x9E3779B97F4A7C15ULL) * nleaves) >> 64);
+}
+
+// ====== Sorting kernels (sort_kernels.h) ======
+// Leaf-sized sort: the kernels for uint64_t keys, std::sort for other types.
+template<typename Key, int Cap>
+void sort_leaf_keys(Key *v, int n) {
+    if constexpr (is_same_v<Key, uint64_t>) {
+        uint64_t tmp[Cap];
+        sort_keys(v, n, tmp);
+    } else {
+        sort(v, v + n);
+    }
+}
 
 // ====== Simplified Leaf Node Variants ======
-struct LeafNode {
-    uint64_t keys[128];
-    int count = 0;
+// Node layout: a 64-byte header line (count, bitmap, version, sibling) comes
+// first and keys start on the next line, so an insert dirties its key line(s)
+// plus exactly one header line. Nodes are padded to a multiple of 256 bytes.
+// Key slots start zeroed, so whole-line loops may read past count.
+template<typename Key = uint64_t, int Cap = 128>
+struct alignas(256) LeafNode {
+    alignas(LINE) int count = 0;
+    uint32_t version = 0;
+    uint64_t bitmap[(Cap + 63) / 64] = {};
+    LeafNode *sibling = nullptr;
+    alignas(LINE) Key keys[Cap] = {};
 };
 
+// Leaf loops walk whole key lines: the inner loop's trip count is a
+// compile-time constant per Key, so it unrolls; only the line loop depends
+// on count.
+template<typename Key>
+constexpr int keys_per_line() { return (int)(LINE / sizeof(Key)); }
+
 // Sorted leaf insert (baseline, causes shifts → more word writes)
-void insert_sorted(LeafNode &leaf, uint64_t key) {
-    if (leaf.count >= 128) return; // prevent overflow
+template<typename Key, int Cap>
+void insert_sorted(LeafNode<Key, Cap> &leaf, const Key &key) {
+    constexpr int PL = keys_per_line<Key>();
+    static_assert(Cap % PL == 0, "capacity must fill whole key lines");
+    const int n = leaf.count;
+    if (n >= Cap) return; // prevent overflow
+    // pos = number of keys below `key`, stopping at the first line that ends at or past it
     int pos = 0;
-    while (pos < leaf.count && leaf.keys[pos] < key) pos++;
-    for (int i = leaf.count; i > pos; i--) {
-        leaf.keys[i] = leaf.keys[i-1];
-        pcm_write();
+    for (int l = 0; l * PL < n; l++) {
+#pragma GCC unroll 16
+        for (int j = 0; j < PL; j++) {
+            const int i = l * PL + j;
+            pos += (i < n) & (leaf.keys[i] < key);
+        }
+        if (pos < min(n, (l + 1) * PL)) break;
+    }
+    // shift keys[pos..n) up one slot, line by line from the top
+    for (int l = n / PL; l >= pos / PL; l--) {
+#pragma GCC unroll 16
+        for (int j = PL - 1; j >= 0; j--) {
+            const int i = l * PL + j;
+            if (i > pos && i <= n) leaf.keys[i] = leaf.keys[i - 1];
+        }
     }
+    pcm_write((n - pos) * key_words<Key>());
     leaf.keys[pos] = key;
     leaf.count++;
-    pcm_write();
-    pcm_flush();
+    pcm_write(key_words<Key>());
+    pcm_flush_range(&leaf.keys[pos], (leaf.count - pos) * sizeof(Key));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count));
+    pcm_fence();
+}
+
+// Batched sorted insert: sort the batch, then merge it with the leaf from the
+// right end in place, in one pass. Every slot from the first changed position
+// to the new end is written once; each of those lines and the header line are
+// flushed once, under a single fence. Keys past capacity are dropped.
+template<typename Key, int Cap>
+void insert_sorted_batch(LeafNode<Key, Cap> &leaf, const Key *batch, int n) {
+    n = min(n, Cap - leaf.count);
+    if (n <= 0) return;
+    Key in[Cap];
+    copy(batch, batch + n, in);
+    sort_leaf_keys<Key, Cap>(in, n);
+
+    int i = leaf.count - 1, j = n - 1, w = leaf.count + n - 1;
+    while (j >= 0) {
+        if (i >= 0 && in[j] < leaf.keys[i]) leaf.keys[w--] = leaf.keys[i--];
+        else                                leaf.keys[w--] = in[j--];
+    }
+    int first = w + 1; // everything below was left in place
+    leaf.count += n;
+    pcm_write((leaf.count - first) * key_words<Key>());
+    pcm_flush_range(&leaf.keys[first], (leaf.count - first) * sizeof(Key));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count));
     pcm_fence();
 }
 
 // Unsorted leaf insert (PCM-friendly append only, minimal writes)
-void insert_unsorted(LeafNode &leaf, uint64_t key) {
-    if (leaf.count >= 128) return;
+template<typename Key, int Cap>
+void insert_unsorted(LeafNode<Key, Cap> &leaf, const Key &key) {
+    if (leaf.count >= Cap) return;
     leaf.keys[leaf.count++] = key;
-    pcm_write();
-    pcm_flush();
+    pcm_write(key_words<Key>());
+    pcm_flush_range(&leaf.keys[leaf.count - 1], sizeof(Key));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count));
     pcm_fence();
 }
 
+// Batched append of n keys (dropped past capacity): one pass over the key
+// lines, each flushed once, one header flush and one fence for the batch.
+template<typename Key, int Cap>
+void insert_unsorted_batch(LeafNode<Key, Cap> &leaf, const Key *keys, int n) {
+    n = min(n, Cap - leaf.count);
+    if (n <= 0) return;
+    const int first = leaf.count;
+    copy(keys, keys + n, &leaf.keys[first]);
+    leaf.count += n;
+    pcm_write(n * key_words<Key>());
+    pcm_flush_range(&leaf.keys[first], n * sizeof(Key));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count));
+    pcm_fence();
+}
+
+// Ordered scan of an unsorted leaf: copy the keys out and sort them at scan
+// time (read-only, no wear). Returns the key count.
+template<typename Key, int Cap>
+int scan_unsorted(const LeafNode<Key, Cap> &leaf, Key *out) {
+    copy(leaf.keys, leaf.keys + leaf.count, out);
+    sort_leaf_keys<Key, Cap>(out, leaf.count);
+    return leaf.count;
+}
+
 // No-wear search (just verifying correctness)
-bool search_leaf(const LeafNode &leaf, uint64_t target) {
-    for (int i = 0; i < leaf.count; i++) {
-        if (leaf.keys[i] == target) return true;
+template<typename Key, int Cap>
+bool search_leaf(const LeafNode<Key, Cap> &leaf, const Key &target) {
+    constexpr int PL = keys_per_line<Key>();
+    for (int l = 0; l * PL < leaf.count; l++) {
+        bool hit = false;
+#pragma GCC unroll 16
+        for (int j = 0; j < PL; j++) {
+            const int i = l * PL + j;
+            hit |= (i < leaf.count) & (leaf.keys[i] == target);
+        }
+        if (hit) return true;
     }
     return false;
 }
 
+// ====== Gapped sorted leaf (ALEX-style, fewer shift writes) ======
+// Same key capacity as LeafNode, but keys are spread over twice as many slots
+// with a bitmap marking occupied ones. A gap repeats the key on its left (0 if
+// none), so the slot array stays non-decreasing and binary search still works.
+// Leading gaps hold 0 and can sit before a real key 0, so lookups step past
+// unoccupied slots equal to the key before testing occupancy.
+// An insert shifts only up to the nearest gap; if that gap is too far away the
+// neighbourhood is dense and the whole leaf is re-spread evenly.
+static const int GAP_CAP       = 128;          // max keys, same as LeafNode
+static const int GAP_SLOTS     = GAP_CAP * 2;  // 2 KiB of slots, <= 50% dense
+static const int GAP_MAX_SHIFT = 16;           // re-spread beyond this distance
+
+struct alignas(256) GappedLeafNode {
+    alignas(LINE) int count = 0;                 // header line
+    uint64_t bitmap[GAP_SLOTS / 64] = {};
+    alignas(LINE) uint64_t slots[GAP_SLOTS] = {};
+};
+
+inline bool gap_occupied(const GappedLeafNode &leaf, int i) {
+    return (leaf.bitmap[i / 64] >> (i % 64)) & 1;
+}
+
+inline void gap_set_occupied(GappedLeafNode &leaf, int i) {
+    leaf.bitmap[i / 64] |= 1ULL << (i % 64);
+    pcm_write(); // one bitmap word
+}
+
+// Rewrite every slot (keys plus gap fill) and the bitmap; one flush per line.
+void respread_gapped(GappedLeafNode &leaf, uint64_t extra_key) {
+    uint64_t tmp[GAP_CAP + 1];
+    int n = 0;
+    bool placed = false;
+    for (int i = 0; i < GAP_SLOTS; i++) {
+        if (!gap_occupied(leaf, i)) continue;
+        if (!placed && extra_key <= leaf.slots[i]) { tmp[n++] = extra_key; placed = true; }
+        tmp[n++] = leaf.slots[i];
+    }
+    if (!placed) tmp[n++] = extra_key;
+
+    memset(leaf.bitmap, 0, sizeof(leaf.bitmap));
+    uint64_t fill = 0;
+    int next = 0;
+    for (int i = 0; i < GAP_SLOTS; i++) {
+        // key j lands in the middle of its 1/n share of the slots
+        if (next < n && i == (int)((2LL * next + 1) * GAP_SLOTS / (2LL * n))) {
+            fill = tmp[next++];
+            leaf.bitmap[i / 64] |= 1ULL << (i % 64);
+        }
+        leaf.slots[i] = fill;
+        pcm_write();
+    }
+    leaf.count = n;
+    pcm_write(GAP_SLOTS / 64);
+    pcm_flush_range(leaf.slots, sizeof(leaf.slots));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count)); // header: count + bitmap
+    pcm_fence();
+}
+
+// First slot >= key that is not a leading 0 gap; it is occupied (any other
+// gap repeats a smaller key) or past the end.
+inline int gapped_lower_bound(const GappedLeafNode &leaf, uint64_t key) {
+    int pos = lower_bound(leaf.slots, leaf.slots + GAP_SLOTS, key) - leaf.slots;
+    while (pos < GAP_SLOTS && leaf.slots[pos] == key && !gap_occupied(leaf, pos)) pos++;
+    return pos;
+}
+
+void insert_gapped(GappedLeafNode &leaf, uint64_t key) {
+    if (leaf.count >= GAP_CAP) return; // prevent overflow
+    int pos = gapped_lower_bound(leaf, key);
+
+    int lo, hi; // written slot range, for line-accurate flushing
+    if (pos > 0 && !gap_occupied(leaf, pos - 1)) {
+        leaf.slots[pos - 1] = key;
+        pcm_write();
+        gap_set_occupied(leaf, pos - 1);
+        lo = hi = pos - 1;
+    } else {
+        int right = pos;
+        while (right < GAP_SLOTS && gap_occupied(leaf, right)) right++;
+        int left = pos - 1;
+        while (left >= 0 && gap_occupied(leaf, left)) left--;
+        int dr = right < GAP_SLOTS ? right - pos : INT_MAX;
+        int dl = left >= 0 ? pos - 1 - left : INT_MAX;
+        if (min(dr, dl) > GAP_MAX_SHIFT) {
+            respread_gapped(leaf, key);
+            return;
+        }
+        if (dr <= dl) {
+            for (int i = right; i > pos; i--) {
+                leaf.slots[i] = leaf.slots[i - 1];
+                pcm_write();
+            }
+            leaf.slots[pos] = key;
+            pcm_write();
+            gap_set_occupied(leaf, right);
+            lo = pos; hi = right;
+        } else {
+            for (int i = left; i < pos - 1; i++) {
+                leaf.slots[i] = leaf.slots[i + 1];
+                pcm_write();
+            }
+            leaf.slots[pos - 1] = key;
+            pcm_write();
+            gap_set_occupied(leaf, left);
+            lo = left; hi = pos - 1;
+        }
+    }
+    leaf.count++;
+    pcm_flush_range(&leaf.slots[lo], (hi - lo + 1) * sizeof(uint64_t));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count)); // header: count + bitmap
+    pcm_fence();
+}
+
+bool search_gapped(const GappedLeafNode &leaf, uint64_t target) {
+    int pos = gapped_lower_bound(leaf, target);
+    return pos < GAP_SLOTS && leaf.slots[pos] == target && gap_occupied(leaf, pos);
+}
+
+// ====== Hash-slotted leaf (in-leaf open addressing) ======
+// Keys go to a slot chosen by a multiplicative hash and probe linearly to the
+// end of the next cache line, so a lookup touches at most two lines. An insert
+// writes one slot plus one bitmap word. If both lines are full the insert is
+// rejected (a real tree would split). Ordered scans sort at scan time.
+static const int HASH_SLOTS      = 128;   // same footprint as LeafNode
+static const int SLOTS_PER_LINE  = 8;
+
+struct alignas(256) HashLeafNode {
+    alignas(LINE) int count = 0;                 // header line
+    uint64_t bitmap[HASH_SLOTS / 64] = {};
+    alignas(LINE) uint64_t slots[HASH_SLOTS];
+};
+
+inline int hash_slot(uint64_t key) {
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> 57); // top 7 bits: 0..127
+}
+
+inline bool hash_occupied(const HashLeafNode &leaf, int i) {
+    return (leaf.bitmap[i / 64] >> (i % 64)) & 1;
+}
+
+// Probe window: home slot up to the end of the following line.
+inline int hash_probe_end(int home) {
+    return (home / SLOTS_PER_LINE + 2) * SLOTS_PER_LINE;
+}
+
+void insert_hashed(HashLeafNode &leaf, uint64_t key) {
+    if (leaf.count >= HASH_SLOTS) return; // prevent overflow
+    int home = hash_slot(key);
+    for (int p = home; p < hash_probe_end(home); p++) {
+        int i = p % HASH_SLOTS;
+        if (hash_occupied(leaf, i)) continue;
+        leaf.slots[i] = key;
+        leaf.bitmap[i / 64] |= 1ULL << (i % 64);
+        leaf.count++;
+        pcm_write(2);  // slot + bitmap word
+        pcm_flush_range(&leaf.slots[i], sizeof(uint64_t));
+        pcm_flush_range(&leaf.count, sizeof(leaf.count)); // header: count + bitmap
+        pcm_fence();
+        return;
+    }
+    // probe window full: drop, like the other leaves at capacity
+}
+
+bool search_hashed(const HashLeafNode &leaf, uint64_t target) {
+    int home = hash_slot(target);
+    for (int p = home; p < hash_probe_end(home); p++) {
+        int i = p % HASH_SLOTS;
+        if (!hash_occupied(leaf, i)) return false; // no deletes: a hole ends the chain
+        if (leaf.slots[i] == target) return true;
+    }
+    return false;
+}
+
+// Ordered scan: gather occupied slots and sort them (read-only, no wear).
+void scan_hashed(const HashLeafNode &leaf, vector<uint64_t> &out) {
+    out.clear();
+    for (int i = 0; i < HASH_SLOTS; i++)
+        if (hash_occupied(leaf, i)) out.push_back(leaf.slots[i]);
+    sort_leaf_keys<uint64_t, HASH_SLOTS>(out.data(), (int)out.size());
+}
+
+// ====== Frame-of-reference compressed sorted leaf ======
+// Keys in one leaf share their high bits, so a 4 KiB leaf stores a 64-bit
+// base in the header line plus sorted 16- or 32-bit deltas: 2016 or 1008 keys
+// instead of 504 plain uint64_t keys. Deltas keep key order, so search never
+// decodes: binary search over the first delta of each line, then one SIMD
+// compare across that line. A key below the base forces a re-encode of every
+// delta (charged in full); a key out of delta range is rejected (would split).
+template<typename Delta>
+struct alignas(256) ForLeafNode {
+    static const int CAP      = (4096 - LINE) / sizeof(Delta);
+    static const int PER_LINE = LINE / sizeof(Delta);
+    static constexpr uint64_t MAX_DELTA = numeric_limits<Delta>::max();
+
+    alignas(LINE) int count = 0;     // header line
+    uint32_t version = 0;
+    uint64_t base = 0;
+    ForLeafNode *sibling = nullptr;
+    alignas(LINE) Delta deltas[CAP] = {};
+};
+static_assert(sizeof(ForLeafNode<uint16_t>) == 4096 && sizeof(ForLeafNode<uint32_t>) == 4096,
+              "compressed leaves are exactly 4 KiB");
+
+inline uint64_t bytes_to_words(size_t bytes) { return (bytes + 7) / 8; }
+
+template<typename Delta>
+void insert_for(ForLeafNode<Delta> &leaf, uint64_t key) {
+    using Node = ForLeafNode<Delta>;
+    if (leaf.count >= Node::CAP) return; // prevent overflow
+    if (leaf.count == 0) {
+        leaf.base = key;
+        pcm_write(); // base word (header line flushed below)
+    } else if (key < leaf.base) {
+        uint64_t shift = leaf.base - key;
+        if (leaf.deltas[leaf.count - 1] + shift > Node::MAX_DELTA) return;
+        // re-encode: every delta is rewritten against the new base
+        for (int i = 0; i < leaf.count; i++) leaf.deltas[i] += (Delta)shift;
+        leaf.base = key;
+        pcm_write(bytes_to_words(leaf.count * sizeof(Delta)) + 1);
+        pcm_flush_range(leaf.deltas, leaf.count * sizeof(Delta));
+    }
+    if (key - leaf.base > Node::MAX_DELTA) return;
+
+    Delta d = (Delta)(key - leaf.base);
+    int pos = lower_bound(leaf.deltas, leaf.deltas + leaf.count, d) - leaf.deltas;
+    memmove(&leaf.deltas[pos + 1], &leaf.deltas[pos], (leaf.count - pos) * sizeof(Delta));
+    leaf.deltas[pos] = d;
+    leaf.count++;
+    // shifted bytes rounded up to whole words
+    pcm_write(bytes_to_words((leaf.count - pos) * sizeof(Delta)));
+    pcm_flush_range(&leaf.deltas[pos], (leaf.count - pos) * sizeof(Delta));
+    pcm_flush_range(&leaf.count, sizeof(leaf.count)); // header: count + base
+    pcm_fence();
+}
+
+#ifdef AVX2_DISPATCH
+// One full line of deltas in two registers; picked at runtime (sort_kernels.h).
+template<typename Delta>
+AVX2_FN bool line_contains_avx2(const Delta *line, Delta d) {
+    __m256i a = _mm256_load_si256((const __m256i *)line);
+    __m256i b = _mm256_load_si256((const __m256i *)line + 1);
+    __m256i n, ea, eb;
+    if constexpr (sizeof(Delta) == 2) {
+        n = _mm256_set1_epi16((short)d);
+        ea = _mm256_cmpeq_epi16(a, n); eb = _mm256_cmpeq_epi16(b, n);
+    } else {
+        n = _mm256_set1_epi32((int)d);
+        ea = _mm256_cmpeq_epi32(a, n); eb = _mm256_cmpeq_epi32(b, n);
+    }
+    return _mm256_movemask_epi8(_mm256_or_si256(ea, eb)) != 0;
+}
+#endif
+
+// Compare one line of deltas against d; `valid` lanes are live.
+template<typename Delta>
+inline bool line_contains(const Delta *line, int valid, Delta d) {
+#ifdef AVX2_DISPATCH
+    if (valid == (int)(LINE / sizeof(Delta)) && cpu_has_avx2()) return line_contains_avx2(line, d);
+#endif
+    for (int i = 0; i < valid; i++)
+        if (line[i] == d) return true;
+    return false;
+}
+
+template<typename Delta>
+bool search_for(const ForLeafNode<Delta> &leaf, uint64_t target) {
+    using Node = ForLeafNode<Delta>;
+    if (leaf.count == 0 || target < leaf.base || target - leaf.base > Node::MAX_DELTA) return false;
+    Delta d = (Delta)(target - leaf.base);
+    // last line whose first delta is <= d
+    int lo = 0, hi = (leaf.count - 1) / Node::PER_LINE;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (leaf.deltas[mid * Node::PER_LINE] <= d) lo = mid;
+        else                                        hi = mid - 1;
+    }
+    int first = lo * Node::PER_LINE;
+    return line_contains(&leaf.deltas[first], min(Node::PER_LINE, leaf.count - first), d);
+}
+
 // ====== Simple multi-leaf tree harness (no latches, no HTM, DRAM only) ======
+// Leaves are unsorted (append) by default; Sorted keeps every leaf in key
+// order, with insert_sorted per key and insert_sorted_batch per partition.
+template<typename Key = uint64_t, int Cap = 128, bool Sorted = false>
 class SimpleBPlusTree {
 public:
-    vector<LeafNode> leaves;
-    SimpleBPlusTree(int num_leaves) { leaves.resize(num_leaves); }
+    using Leaf = LeafNode<Key, Cap>;
+    NodeArena<Leaf> arena;
+    vector<Leaf *> leaves;
+    SimpleBPlusTree(int num_leaves) {
+        for (int i = 0; i < num_leaves; i++) leaves.push_back(arena.alloc());
+    }
+
+    static size_t route(const Key &key, size_t nleaves) { return leaf_route(key_route(key), nleaves); }
+    size_t route(const Key &key) const { return route(key, leaves.size()); }
+
+    bool search(const Key &key) const { return search_leaf(*leaves[route(key)], key); }
 
-    void insert(uint64_t key) {
-        int i = key % leaves.size();
-        insert_unsorted(leaves[i], key);
+    void insert(const Key &key) {
+        if constexpr (Sorted) insert_sorted(*leaves[route(key)], key);
+        else                  insert_unsorted(*leaves[route(key)], key);
+    }
+
+    // Batched insert in three passes: route every key; radix-partition the
+    // batch by leaf through software write-combining buffers (one line per
+    // leaf, written to the partition area only when full, so the scatter
+    // streams whole lines instead of touching a random line per key); then
+    // append (or, for sorted leaves, merge) each partition into its leaf in
+    // one cache-warm pass.
+    void insert_batch(const Key *keys, size_t n) {
+        const size_t L = leaves.size();
+        dest.resize(n);
+        start.assign(L + 1, 0);
+        for (size_t i = 0; i < n; i++) {
+            dest[i] = (uint32_t)route(keys[i]);
+            start[dest[i] + 1]++;
+        }
+        for (size_t d = 0; d < L; d++) start[d + 1] += start[d];
+
+        parted.resize(n);
+        cursor.assign(start.begin(), start.end() - 1);
+        wc.resize(L);
+        wc_fill.assign(L, 0);
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t d = dest[i];
+            WcLine &b = wc[d];
+            b.k[wc_fill[d]++] = keys[i];
+            if (wc_fill[d] == WC_KEYS) {
+                copy(b.k, b.k + WC_KEYS, &parted[cursor[d]]);
+                cursor[d] += WC_KEYS;
+                wc_fill[d] = 0;
+            }
+        }
+        for (size_t d = 0; d < L; d++) {
+            copy(wc[d].k, wc[d].k + wc_fill[d], &parted[cursor[d]]);
+            if (start[d + 1] == start[d]) continue;
+            const int m = (int)(start[d + 1] - start[d]);
+            if constexpr (Sorted) insert_sorted_batch(*leaves[d], &parted[start[d]], m);
+            else                  insert_unsorted_batch(*leaves[d], &parted[start[d]], m);
+        }
+    }
+
+    // insert_batch's persistence without its partitioning: keys are appended
+    // one by one in arrival order (a random leaf line per key), then every
+    // leaf touched flushes its new key lines and header once and fences once,
+    // exactly as insert_batch does. Separates the two effects of batching.
+    void insert_deferred(const Key *keys, size_t n) {
+        static_assert(!Sorted, "insert_deferred appends; sorted leaves use insert_batch");
+        const size_t L = leaves.size();
+        first_new.assign(L, -1);
+        touched.clear();
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t d = (uint32_t)route(keys[i]);
+            Leaf &leaf = *leaves[d];
+            if (leaf.count >= Cap) continue;
+            if (first_new[d] < 0) { first_new[d] = leaf.count; touched.push_back(d); }
+            leaf.keys[leaf.count++] = keys[i];
+        }
+        for (uint32_t d : touched) {
+            Leaf &leaf = *leaves[d];
+            const int first = first_new[d];
+            pcm_write((leaf.count - first) * key_words<Key>());
+            pcm_flush_range(&leaf.keys[first], (leaf.count - first) * sizeof(Key));
+            pcm_flush_range(&leaf.count, sizeof(leaf.count));
+            pcm_fence();
+        }
     }
 
     uint64_t size() {
         uint64_t total = 0;
-        for (auto &l : leaves) total += l.count;
+        for (auto *l : leaves) total += l->count;
         return total;
     }
+
+    bool empty() { return size() == 0; }
+
+    size_t underfull_leaves() {
+        size_t n = 0;
+        for (auto *l : leaves) n += l->count <= Cap / 2;
+        return n;
+    }
+
+private:
+    // insert_batch / insert_deferred scratch, kept across calls
+    static const int WC_KEYS = sizeof(Key) >= LINE ? 1 : LINE / sizeof(Key);
+    struct alignas(LINE) WcLine { Key k[WC_KEYS]; };
+    vector<uint32_t> dest, start, cursor, touched;
+    vector<int> first_new;
+    vector<Key> parted;
+    vector<WcLine> wc;
+    vector<uint8_t> wc_fill;
+};
+
+// ====== Structure-of-arrays storage mode for the same tree ======
+// Leaf headers (count, version, min/max key) are packed into one dense array
+// and the keys live in a separate area, Cap slots per leaf. The total is kept
+// incrementally, so size() and empty() are O(1) and header-only scans
+// (routing, stats, compaction candidates) stream one array that stays in
+// cache instead of striding a full node per leaf.
+constexpr size_t pow2_at_least(size_t n) { return n <= 1 ? 1 : 2 * pow2_at_least((n + 1) / 2); }
+
+template<typename Key = uint64_t, int Cap = 128>
+class SimpleBPlusTreeSoA {
+public:
+    // Aligned to its size rounded up to a power of two, so no header
+    // straddles a line and a header flush is always one line.
+    struct alignas(pow2_at_least(2 * sizeof(Key) + 8)) LeafHeader {
+        int count = 0;
+        uint32_t version = 0;
+        Key min_key{}, max_key{};
+    };
+    static_assert(sizeof(LeafHeader) <= LINE && LINE % alignof(LeafHeader) == 0,
+                  "a leaf header must fit in one line");
+
+    vector<LeafHeader> headers;
+    vector<Key> keys; // leaf i owns keys[i * Cap, (i + 1) * Cap)
+    uint64_t total = 0;
+
+    SimpleBPlusTreeSoA(int num_leaves) : headers(num_leaves), keys((size_t)num_leaves * Cap) {}
+
+    void insert(const Key &key) {
+        size_t i = leaf_route(key_route(key), headers.size());
+        LeafHeader &h = headers[i];
+        if (h.count >= Cap) return;
+        Key *slot = &keys[i * Cap + h.count];
+        *slot = key;
+        uint64_t words = key_words<Key>();
+        if (h.count == 0 || key < h.min_key) { h.min_key = key; words += key_words<Key>(); }
+        if (h.count == 0 || h.max_key < key) { h.max_key = key; words += key_words<Key>(); }
+        h.count++;
+        h.version++;
+        total++;
+        pcm_write(words);
+        pcm_flush_range(slot, sizeof(Key));
+        pcm_flush_range(&h, sizeof(h));
+        pcm_fence();
+    }
+
+    // Route, reject on the header's key range, then scan the leaf's slots.
+    bool search(const Key &key) const {
+        size_t i = leaf_route(key_route(key), headers.size());
+        const LeafHeader &h = headers[i];
+        if (h.count == 0 || key < h.min_key || h.max_key < key) return false;
+        const Key *k = &keys[i * Cap];
+        return find(k, k + h.count, key) != k + h.count;
+    }
+
+    uint64_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    // Header-only scan: leaves at most half full (merge/compaction candidates)
+    size_t underfull_leaves() const {
+        size_t n = 0;
+        for (auto &h : headers) n += h.count <= Cap / 2;
+        return n;
+    }
+};
+
+// ====== DRAM read cache for hot PM leaves (CLOCK, write-through) ======
+// Mirrors up to `frames` of the tree's (PM-resident) leaves in DRAM. A lookup
+// on a mirrored leaf never touches PM; a miss pays one injected PM read,
+// copies the leaf into the frame CLOCK picks (second chance on the reference
+// bit) and is served from the copy. Inserts go to the PM leaf with its normal
+// persistence and then copy the appended slots and count into the mirror, so
+// the cache never holds dirty state and eviction is free.
+inline void pm_read_delay(uint64_t ns) {
+    if (ns) pm_spin_until(steady_clock::now() + nanoseconds(ns));
+}
+
+template<typename Key = uint64_t, int Cap = 128>
+class LeafReadCache {
+public:
+    using Tree = SimpleBPlusTree<Key, Cap>;
+    using Leaf = typename Tree::Leaf;
+
+    uint64_t hits = 0, misses = 0;
+
+    LeafReadCache(Tree &t, size_t frames, uint64_t pm_read_ns)
+        : tree(t), mirror(frames), owner(frames, -1), ref(frames, 0),
+          frame_of(t.leaves.size(), -1), read_ns(pm_read_ns) {}
+
+    bool search(const Key &key) {
+        size_t i = tree.route(key);
+        int f = frame_of[i];
+        if (f >= 0) {
+            ref[f] = 1;
+            hits++;
+            return search_leaf(mirror[f], key);
+        }
+        misses++;
+        pm_read_delay(read_ns);
+        if (mirror.empty()) return search_leaf(*tree.leaves[i], key);
+        return search_leaf(mirror[admit(i)], key);
+    }
+
+    void insert(const Key &key) {
+        size_t i = tree.route(key);
+        tree.insert(key);
+        int f = frame_of[i];
+        if (f < 0) return;
+        const Leaf &leaf = *tree.leaves[i];
+        Leaf &m = mirror[f];
+        for (int k = m.count; k < leaf.count; k++) m.keys[k] = leaf.keys[k];
+        m.count = leaf.count;
+        m.version = leaf.version;
+    }
+
+    double hit_rate() const { return hits + misses ? (double)hits / (hits + misses) : 0.0; }
+
+    // DRAM held by the cache: leaf frames, CLOCK state and the leaf -> frame map
+    size_t dram_bytes() const {
+        if (mirror.empty()) return 0;
+        return mirror.size() * (sizeof(Leaf) + sizeof(int) + 1) + frame_of.size() * sizeof(int);
+    }
+
+private:
+    Tree &tree;
+    vector<Leaf> mirror;
+    vector<int> owner;    // frame -> leaf index, -1 if empty
+    vector<uint8_t> ref;  // CLOCK reference bits
+    vector<int> frame_of; // leaf index -> frame, -1 if not mirrored
+    size_t hand = 0;
+    uint64_t read_ns;
+
+    int admit(size_t leaf) {
+        while (ref[hand]) {
+            ref[hand] = 0;
+            hand = (hand + 1) % mirror.size();
+        }
+        int f = (int)hand;
+        hand = (hand + 1) % mirror.size();
+        if (owner[f] >= 0) frame_of[owner[f]] = -1;
+        owner[f] = (int)leaf;
+        frame_of[leaf] = f;
+        mirror[f] = *tree.leaves[leaf];
+        ref[f] = 1;
+        return f;
+    }
+};
+
+// ====== Hot/cold leaf tiering: fast (DRAM) and slow (PM or CXL) tiers ======
+// Every leaf is served from exactly one tier and each access pays that
+// tier's injected latency. Leaves are placed by capacity up front: the fast
+// tier is filled first (in leaf order, there is no access history yet) and
+// the rest start slow, so a fast tier that holds every leaf never migrates.
+// Per-leaf access counts are halved after every pass (frequency with decay).
+// Every pass_ops accesses a migration pass promotes the hottest leaves not
+// yet fast, demoting the coldest fast leaves to make room (only for a leaf
+// at least twice as hot, so near-ties do not churn), with at most max_moves
+// moves per pass (migration bandwidth) and never beyond a tier's capacity.
+// A persistent slow tier is every leaf's durable home and the fast tier is
+// write-through: an insert into a fast leaf also writes the PM copy and
+// pays the slow tier's latency before it returns (the tree's own flushes
+// and fence are that PM write), so every insert is durable at return and a
+// demotion just drops the DRAM copy. Otherwise a move reads the leaf from
+// one tier and writes it into the other, paying both latencies inline.
+template<typename Key = uint64_t, int Cap = 128>
+class LeafTiering {
+public:
+    using Tree = SimpleBPlusTree<Key, Cap>;
+    using Leaf = typename Tree::Leaf;
+
+    struct Tier {
+        size_t capacity, used;
+        uint64_t access_ns;
+    };
+
+    uint64_t accesses = 0, fast_accesses = 0, moves = 0, copies = 0;
+
+    LeafTiering(Tree &t, size_t fast_capacity, uint64_t fast_ns, size_t slow_capacity,
+                uint64_t slow_ns, bool slow_persistent, uint64_t pass_ops, size_t max_moves)
+        : tree(t), fast{fast_capacity, 0, fast_ns}, slow{slow_capacity, t.leaves.size(), slow_ns},
+          slow_persistent(slow_persistent), pass_ops(pass_ops), max_moves(max_moves),
+          in_fast(t.leaves.size(), 0), hits(t.leaves.size(), 0) {
+        const size_t k = min(fast.capacity, t.leaves.size());
+        fill(in_fast.begin(), in_fast.begin() + k, 1);
+        fast.used = k;
+        slow.used -= k;
+        assert(slow.used <= slow.capacity);
+    }
+
+    bool search(const Key &key) {
+        size_t i = touch(key);
+        return search_leaf(*tree.leaves[i], key);
+    }
+
+    void insert(const Key &key) {
+        size_t i = touch(key);
+        if (in_fast[i] && slow_persistent) pm_read_delay(slow.access_ns); // write-through
+        tree.insert(key);
+    }
+
+    double fast_share() const { return accesses ? (double)fast_accesses / accesses : 0.0; }
+    uint64_t migrated_bytes() const { return copies * sizeof(Leaf); }
+
+private:
+    Tree &tree;
+    Tier fast, slow;
+    bool slow_persistent;
+    uint64_t pass_ops, since_pass = 0;
+    size_t max_moves;
+    vector<uint8_t> in_fast;
+    vector<uint32_t> hits;
+
+    size_t touch(const Key &key) {
+        size_t i = tree.route(key);
+        accesses++;
+        hits[i]++;
+        if (in_fast[i]) fast_accesses++;
+        pm_read_delay(in_fast[i] ? fast.access_ns : slow.access_ns);
+        if (++since_pass >= pass_ops) migrate();
+        return i;
+    }
+
+    void move(size_t i, bool to_fast) {
+        Tier &from = to_fast ? slow : fast, &to = to_fast ? fast : slow;
+        if (to_fast || !slow_persistent) { // the PM copy of a demoted leaf is already current
+            pm_read_delay(from.access_ns + to.access_ns);
+            copies++;
+        }
+        from.used--;
+        to.used++;
+        in_fast[i] = to_fast;
+        moves++;
+    }
+
+    void migrate() {
+        since_pass = 0;
+        const size_t n = hits.size(), k = min(fast.capacity, n);
+        vector<uint32_t> order(n);
+        iota(order.begin(), order.end(), 0);
+        partial_sort(order.begin(), order.begin() + k, order.end(),
+                     [&](uint32_t a, uint32_t b) { return hits[a] > hits[b]; });
+        vector<uint8_t> wanted(n, 0);
+        for (size_t j = 0; j < k; j++) wanted[order[j]] = hits[order[j]] > 0;
+        vector<uint32_t> victims; // fast leaves outside the hot set, coldest last
+        for (size_t i = 0; i < n; i++)
+            if (in_fast[i] && !wanted[i]) victims.push_back(i);
+        sort(victims.begin(), victims.end(), [&](uint32_t a, uint32_t b) { return hits[a] > hits[b]; });
+
+        size_t budget = max_moves;
+        for (size_t j = 0; j < k && budget; j++) {
+            size_t i = order[j];
+            if (!wanted[i] || in_fast[i]) continue;
+            if (fast.used == fast.capacity) {
+                if (victims.empty() || slow.used == slow.capacity || budget < 2) break;
+                if (hits[i] < 2 * hits[victims.back()]) break; // hysteresis: not worth a swap
+                move(victims.back(), false);
+                victims.pop_back();
+                budget--;
+            }
+            move(i, true);
+            budget--;
+        }
+        for (auto &h : hits) h /= 2;
+    }
+};
+
+// Explicit instantiations: leaf capacity sweep for 32-, 64- and 128-bit and
+// 16-byte string keys, so every variant is compiled with a constant Cap.
+#define INSTANTIATE_LEAF(Key, Cap)                                           \
+    template struct LeafNode<Key, Cap>;                                      \
+    template class SimpleBPlusTree<Key, Cap>;                                \
+    template class SimpleBPlusTreeSoA<Key, Cap>;                             \
+    template class LeafReadCache<Key, Cap>;                                  \
+    template class LeafTiering<Key, Cap>;                                    \
+    template void insert_sorted<Key, Cap>(LeafNode<Key, Cap> &, const Key &);   \
+    template void insert_unsorted<Key, Cap>(LeafNode<Key, Cap> &, const Key &); \
+    template void insert_unsorted_batch<Key, Cap>(LeafNode<Key, Cap> &, const Key *, int); \
+    template void insert_sorted_batch<Key, Cap>(LeafNode<Key, Cap> &, const Key *, int); \
+    template int scan_unsorted<Key, Cap>(const LeafNode<Key, Cap> &, Key *);              \
+    template bool search_leaf<Key, Cap>(const LeafNode<Key, Cap> &, const Key &);
+#define INSTANTIATE_CAPS(Key) \
+    INSTANTIATE_LEAF(Key, 32) INSTANTIATE_LEAF(Key, 64) INSTANTIATE_LEAF(Key, 128) INSTANTIATE_LEAF(Key, 256)
+INSTANTIATE_CAPS(uint32_t)
+INSTANTIATE_CAPS(uint64_t)
+INSTANTIATE_CAPS(Key128)
+INSTANTIATE_CAPS(FixedStr16)
+#undef INSTANTIATE_CAPS
+#undef INSTANTIATE_LEAF
+
+static_assert(sizeof(LeafNode<>) % 256 == 0, "node size must be a multiple of 256 bytes");
+static_assert(offsetof(LeafNode<>, keys) == LINE, "keys must start right after the header line");
+static_assert(sizeof(GappedLeafNode) % 256 == 0 && sizeof(HashLeafNode) % 256 == 0,
+              "node size must be a multiple of 256 bytes");
+
+// ====== Gapped leaf: key 0 next to the leading 0 gaps ======
+// Key 0 among other keys, through enough inserts to force re-spreads: it
+// must stay findable and be stored exactly once.
+bool check_gapped_zero() {
+    bool ok = true;
+    for (int extra = 1; extra < GAP_CAP; extra += 7) {
+        GappedLeafNode leaf;
+        insert_gapped(leaf, 0);
+        for (int i = 1; i <= extra; i++) insert_gapped(leaf, (uint64_t)i * 1000);
+        int zeros = 0;
+        for (int i = 0; i < GAP_SLOTS; i++) zeros += gap_occupied(leaf, i) && leaf.slots[i] == 0;
+        ok = ok && search_gapped(leaf, 0) && zeros == 1 && leaf.count == extra + 1;
+        for (int i = 1; i <= extra; i++) ok = ok && search_gapped(leaf, (uint64_t)i * 1000);
+    }
+    return ok;
+}
+
+// ====== Node arena: trees built and destroyed back to back ======
+// Each tree owns an arena; a new arena often lands at the address of the one
+// just destroyed. Leaf counts are not multiples of REFILL, so every tree
+// leaves part of a refill in the thread cache when it dies.
+bool check_arena_reuse() {
+    bool ok = true;
+    for (int t = 0; t < 200; t++) {
+        const int leaves = 1 + t % 100;
+        SimpleBPlusTree<> tree(leaves);
+        const uint64_t n = (uint64_t)leaves * 16; // well under Cap per leaf
+        for (uint64_t k = 1; k <= n; k++) tree.insert(k * 7919);
+        for (uint64_t k = 1; k <= n; k++) ok = ok && tree.search(k * 7919);
+        ok = ok && tree.size() == n && !tree.search(3);
+    }
+    return ok;
+}
+
+// ====== Key/Cap sweep: every instantiation through insert and search ======
+template<typename Key> Key key_from(uint64_t x);
+template<> uint32_t key_from<uint32_t>(uint64_t x) { return (uint32_t)x; }
+template<> uint64_t key_from<uint64_t>(uint64_t x) { return x; }
+template<> Key128 key_from<Key128>(uint64_t x) { return Key128{x >> 7, x * 0x9E3779B97F4A7C15ULL}; }
+template<> FixedStr16 key_from<FixedStr16>(uint64_t x) {
+    FixedStr16 k;
+    snprintf(k.b, sizeof(k.b), "%015llx", (unsigned long long)x);
+    return k;
+}
+
+// Fill a sorted and an unsorted leaf to capacity (one extra key must be
+// dropped), then every key must be found, a missing key must not, and the
+// sorted leaf must be in order. A small tree of the same Key/Cap takes the
+// keys through insert and search as well.
+template<typename Key, int Cap>
+bool check_instantiation(mt19937_64 &rng) {
+    vector<Key> keys;
+    set<uint64_t> seen;
+    while ((int)keys.size() < Cap + 1) {
+        uint64_t x = rng() % 4'000'000'000ULL + 1;
+        if (seen.insert(x).second) keys.push_back(key_from<Key>(x));
+    }
+    auto sorted = make_unique<LeafNode<Key, Cap>>();
+    auto unsorted = make_unique<LeafNode<Key, Cap>>();
+    SimpleBPlusTree<Key, Cap> tree(4);
+    for (auto &k : keys) {
+        insert_sorted(*sorted, k);
+        insert_unsorted(*unsorted, k);
+    }
+    bool ok = sorted->count == Cap && unsorted->count == Cap
+              && is_sorted(sorted->keys, sorted->keys + Cap);
+    for (int i = 0; i < Cap; i++) {
+        ok = ok && search_leaf(*sorted, keys[i]) && search_leaf(*unsorted, keys[i]);
+        tree.insert(keys[i]);
+    }
+    ok = ok && !search_leaf(*sorted, keys[Cap]) && !search_leaf(*unsorted, keys[Cap]);
+    for (int i = 0; i < Cap; i++) ok = ok && tree.search(keys[i]);
+    return ok;
+}
+
+void run_instantiation_checks(mt19937_64 &rng) {
+    int passed = 0, total = 0;
+    auto caps = [&](auto key) {
+        using Key = decltype(key);
+        passed += check_instantiation<Key, 32>(rng);
+        passed += check_instantiation<Key, 64>(rng);
+        passed += check_instantiation<Key, 128>(rng);
+        passed += check_instantiation<Key, 256>(rng);
+        total += 4;
+    };
+    caps(uint32_t{});
+    caps(uint64_t{});
+    caps(Key128{});
+    caps(FixedStr16{});
+    cout << "Key/Cap instantiations through insert and search: " << passed << " of " << total << " ok\n";
+}
+
+// ====== 4 KiB leaf comparison: plain uint64_t vs FOR-compressed ======
+// Fills one 4 KiB leaf from a key stream confined to one leaf's key range,
+// then times point lookups. Counters are snapshotted per leaf.
+struct LeafRun {
+    double tp_insert, tp_lookup;
+    uint64_t Nw, Nclf, Nmf;
+    int keys, hits;
 };
 
+template<typename LeafT, typename InsertFn, typename SearchFn>
+LeafRun run_4k_leaf(LeafT &leaf, const vector<uint64_t> &keys, InsertFn ins, SearchFn find) {
+    const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+    auto t0 = high_resolution_clock::now();
+    for (auto k : keys) ins(leaf, k);
+    auto t1 = high_resolution_clock::now();
+    LeafRun r;
+    r.Nw = Nw - w0; r.Nclf = Nclf - c0; r.Nmf = Nmf - f0;
+    r.keys = leaf.count;
+    r.hits = 0;
+    const int LOOKUPS = 20'000;
+    auto t2 = high_resolution_clock::now();
+    for (int i = 0; i < LOOKUPS; i++)
+        if (find(leaf, keys[i % keys.size()] + (i & 1))) r.hits++;
+    auto t3 = high_resolution_clock::now();
+    r.tp_insert = keys.size() / duration<double>(t1 - t0).count();
+    r.tp_lookup = LOOKUPS / duration<double>(t3 - t2).count();
+    return r;
+}
+
+// ====== Batched sorted inserts: one merge vs per-key insert_sorted ======
+// Each trial takes a 4 KiB sorted leaf half full and adds `batch` keys, either
+// key by key or as one merged batch. Counters cover the batch inserts only.
+void run_batch_sweep(ofstream &csv, mt19937_64 &rng) {
+    using Leaf4k = LeafNode<uint64_t, 504>;
+    const int PREFILL = 252, TRIALS = 2'000;
+    NodeArena<Leaf4k> arena;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    vector<uint64_t> base(PREFILL);
+    for (auto &k : base) k = dist(rng);
+
+    for (int batch : {1, 4, 16, 64, 252}) {
+        arena.reset(); // drop the previous batch size's nodes in one go
+        Leaf4k *seeded = arena.alloc();
+        for (auto k : base) insert_sorted(*seeded, k);
+        vector<uint64_t> keys((size_t)batch * TRIALS);
+        for (auto &k : keys) k = dist(rng);
+        for (bool merged : {false, true}) {
+            Leaf4k *leaf = arena.alloc();
+            double secs = 0;
+            const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+            for (int t = 0; t < TRIALS; t++) {
+                *leaf = *seeded; // reset (a volatile copy, not a measured write)
+                const uint64_t *b = &keys[(size_t)t * batch];
+                auto t0 = high_resolution_clock::now();
+                if (merged) insert_sorted_batch(*leaf, b, batch);
+                else for (int i = 0; i < batch; i++) insert_sorted(*leaf, b[i]);
+                secs += duration<double>(high_resolution_clock::now() - t0).count();
+            }
+            csv << (merged ? "sorted_batch_merge," : "sorted_per_key,") << batch << ","
+                << keys.size() / secs << "," << Nw - w0 << "," << Nclf - c0 << ","
+                << Nmf - f0 << "\n";
+            arena.free(leaf);
+        }
+    }
+}
+
+// ====== Header-only scans: node-per-leaf vs structure-of-arrays ======
+// Both trees take the same keys; then size() and an underfull-leaf scan are
+// timed, and lookups (every other one a stored key) must agree between the
+// two. Runs after the CSV is written since it uses the global counters.
+void run_header_scan_bench(mt19937_64 &rng) {
+    const int LEAVES = 16'384, KEYS = 1'000'000, SCANS = 200, LOOKUPS = 1'000'000;
+    SimpleBPlusTree<> aos(LEAVES);
+    SimpleBPlusTreeSoA<> soa(LEAVES);
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    vector<uint64_t> stored(KEYS);
+    for (int i = 0; i < KEYS; i++) {
+        uint64_t k = dist(rng);
+        stored[i] = k;
+        aos.insert(k);
+        soa.insert(k);
+    }
+
+    auto time_scans = [&](auto &tree, uint64_t &sink) {
+        auto t0 = high_resolution_clock::now();
+        for (int i = 0; i < SCANS; i++) sink += tree.size() + tree.underfull_leaves();
+        return SCANS / duration<double>(high_resolution_clock::now() - t0).count();
+    };
+    uint64_t sink_aos = 0, sink_soa = 0;
+    double aos_rate = time_scans(aos, sink_aos);
+    double soa_rate = time_scans(soa, sink_soa);
+    cout << "Header scans/sec over " << LEAVES << " leaves: node-per-leaf " << aos_rate
+         << ", SoA " << soa_rate << (sink_aos == sink_soa ? "" : " (MISMATCH)") << "\n";
+
+    mt19937_64 probe_rng(7); // its own stream, so later benches see the same rng
+    vector<uint64_t> probes(LOOKUPS);
+    for (int i = 0; i < LOOKUPS; i++) probes[i] = i % 2 ? dist(probe_rng) : stored[probe_rng() % KEYS];
+    auto time_lookups = [&](auto &tree, uint64_t &hits) {
+        auto t0 = high_resolution_clock::now();
+        for (auto k : probes) hits += tree.search(k);
+        return LOOKUPS / duration<double>(high_resolution_clock::now() - t0).count();
+    };
+    uint64_t hits_aos = 0, hits_soa = 0;
+    double aos_lookups = time_lookups(aos, hits_aos);
+    double soa_lookups = time_lookups(soa, hits_soa);
+    cout << "Lookups/sec over " << LEAVES << " leaves: node-per-leaf " << aos_lookups
+         << ", SoA " << soa_lookups << (hits_aos == hits_soa ? "" : " (MISMATCH)") << "\n";
+}
+
+// ====== DRAM read cache over PM leaves: read-heavy, skewed vs uniform ======
+// 4096 half-full leaves; 95% lookups of prefilled keys, 5% new inserts.
+// Lookups pick a prefilled key uniformly, or pick a leaf by Zipf(0.99) rank
+// (hot key ranges -> hot leaves) and then a key in it. Every variant replays
+// the same op stream on a freshly filled tree. pm_uncached
+// pays PM_READ_NS per lookup; dram_only is the same tree without injection.
+void run_read_cache_bench(mt19937_64 &rng) {
+    const int LEAVES = 4'096, PER_LEAF = 64, OPS = 200'000;
+    const uint64_t PM_READ_NS = 300;
+    const double WRITE_RATIO = 0.05;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    uniform_real_distribution<double> u01(0.0, 1.0);
+    vector<uint64_t> prefill((size_t)LEAVES * PER_LEAF);
+    for (auto &k : prefill) k = dist(rng);
+    vector<vector<uint64_t>> by_leaf(LEAVES);
+    for (auto k : prefill) by_leaf[SimpleBPlusTree<>::route(k, LEAVES)].push_back(k);
+    vector<int> leaf_rank(LEAVES);
+    iota(leaf_rank.begin(), leaf_rank.end(), 0);
+    shuffle(leaf_rank.begin(), leaf_rank.end(), rng);
+
+    vector<double> zipf_cdf(LEAVES);
+    double sum = 0;
+    for (size_t r = 0; r < zipf_cdf.size(); r++) zipf_cdf[r] = (sum += 1.0 / pow(r + 1.0, 0.99));
+    for (auto &c : zipf_cdf) c /= sum;
+
+    ofstream csv("results/article1_read_cache.csv");
+    csv << "variant,key_dist,cache_leaves,throughput_ops_sec,hit_rate,dram_overhead_bytes,Nw,Nclf,Nmf\n";
+    for (bool zipf : {false, true}) {
+        struct Op { bool write; uint64_t key; };
+        vector<Op> ops(OPS);
+        for (auto &op : ops) {
+            op.write = u01(rng) < WRITE_RATIO;
+            if (op.write) {
+                op.key = dist(rng);
+            } else if (zipf) {
+                size_t r = lower_bound(zipf_cdf.begin(), zipf_cdf.end(), u01(rng)) - zipf_cdf.begin();
+                const auto &keys = by_leaf[leaf_rank[min(r, (size_t)LEAVES - 1)]];
+                op.key = keys[rng() % keys.size()];
+            } else {
+                op.key = prefill[rng() % prefill.size()];
+            }
+        }
+
+        auto run = [&](const char *name, size_t frames, uint64_t read_ns) {
+            SimpleBPlusTree<> tree(LEAVES);
+            for (auto k : prefill) tree.insert(k);
+            LeafReadCache<> cache(tree, frames, read_ns);
+            const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+            uint64_t found = 0, reads = 0;
+            auto t0 = high_resolution_clock::now();
+            for (auto &op : ops) {
+                if (op.write) cache.insert(op.key);
+                else { found += cache.search(op.key); reads++; }
+            }
+            double tp = OPS / duration<double>(high_resolution_clock::now() - t0).count();
+            csv << name << "," << (zipf ? "zipf99" : "uniform") << "," << frames << "," << tp << ","
+                << cache.hit_rate() << "," << cache.dram_bytes() << ","
+                << Nw - w0 << "," << Nclf - c0 << "," << Nmf - f0 << "\n";
+            if (found != reads) cout << "Read cache " << name << ": MISSED KEYS\n";
+            return make_pair(tp, cache.hit_rate());
+        };
+        double dram = run("dram_only", 0, 0).first;
+        double pm = run("pm_uncached", 0, PM_READ_NS).first;
+        for (int pct : {1, 5, 10, 25}) {
+            auto [tp, hit] = run("pm_cached", LEAVES * pct / 100, PM_READ_NS);
+            if (pct == 10)
+                cout << "Read cache (" << (zipf ? "zipf 0.99" : "uniform") << ", 10% of leaves): hit rate "
+                     << hit << ", " << tp << " ops/sec vs PM " << pm << ", DRAM " << dram << "\n";
+        }
+    }
+}
+
+// ====== Buffered durability: per-op fences vs epoch persists ======
+// The same insert stream into a 1024-leaf tree, durable per op or in epochs
+// of N ops / N us, with and without injected PM write latency. The last
+// row of each latency closes one epoch of every 1000 ops with the PM image
+// kept, then checks that a crash image equals replaying the durable prefix.
+void run_epoch_bench(mt19937_64 &rng) {
+    const int LEAVES = 1'024, OPS = 100'000;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    vector<uint64_t> keys(OPS);
+    for (auto &k : keys) k = dist(rng);
+
+    ofstream csv("results/article1_epoch_persist.csv");
+    csv << "mode,epoch_ops,epoch_us,pm_write_ns,throughput_ops_sec,Nw,Nclf,Nmf,epochs,max_ops_at_risk,max_epoch_us\n";
+    for (uint64_t write_ns : {0, 500}) {
+        pm_write_ns = write_ns;
+        auto run = [&](uint64_t max_ops, uint64_t max_us) {
+            SimpleBPlusTree<> tree(LEAVES);
+            const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+            unique_ptr<EpochPersist> ep;
+            if (max_ops || max_us) ep.reset(new EpochPersist(max_ops, max_us));
+            auto t0 = high_resolution_clock::now();
+            for (auto k : keys) {
+                if (ep) ep->op_begin();
+                tree.insert(k);
+                if (ep) ep->op_done();
+            }
+            if (ep) ep->close();
+            double tp = OPS / duration<double>(high_resolution_clock::now() - t0).count();
+            csv << (ep ? "epoch" : "per_op") << "," << max_ops << "," << max_us << "," << write_ns << ","
+                << tp << "," << Nw - w0 << "," << Nclf - c0 << "," << Nmf - f0 << ","
+                << (ep ? ep->epochs : OPS) << "," << (ep ? ep->max_epoch_ops : 1) << ","
+                << (ep ? ep->max_epoch_us : 0) << "\n";
+            return tp;
+        };
+        double per_op = run(0, 0);
+        run(64, 0);
+        run(1'024, 0);
+        run(0, 100);
+        double ms = run(0, 1'000);
+        cout << "Epoch persist (1 ms epochs, pm_write_ns " << write_ns << "): " << ms
+             << " inserts/sec vs " << per_op << " durable per op\n";
+    }
+    pm_write_ns = 0;
+
+    // Idle writer: a burst of ops, then nothing. The timer must still close
+    // the epoch within the bound.
+    {
+        SimpleBPlusTree<> tree(LEAVES);
+        EpochPersist ep(0, 1'000);
+        for (int i = 0; i < 100; i++) {
+            ep.op_begin();
+            tree.insert(keys[i]);
+            ep.op_done();
+        }
+        this_thread::sleep_for(milliseconds(5));
+        ep.op_begin(); // quiesce the timer while reading its counters
+        cout << "Epoch persist idle writer (1 ms epochs, 5 ms idle): " << ep.durable_ops << " of " << ep.ops
+             << " ops durable, longest epoch " << ep.max_epoch_us << " us\n";
+        ep.op_done();
+    }
+
+    // Crash check: stop mid-epoch, rebuild the tree from the PM image
+    SimpleBPlusTree<> tree(LEAVES), recovered(LEAVES), replay(LEAVES);
+    uint64_t durable;
+    {
+        EpochPersist ep(1'000, 0, true);
+        for (int i = 0; i < OPS / 2 + 337; i++) {
+            tree.insert(keys[i]);
+            ep.op_done();
+        }
+        durable = ep.durable_ops;
+        for (int i = 0; i < LEAVES; i++)
+            ep.restore(recovered.leaves[i], tree.leaves[i], sizeof(*tree.leaves[i]));
+    }
+    for (uint64_t i = 0; i < durable; i++) replay.insert(keys[i]);
+    bool ok = true;
+    for (int i = 0; i < LEAVES; i++) {
+        const auto &a = *recovered.leaves[i], &b = *replay.leaves[i];
+        ok = ok && a.count == b.count && equal(a.keys, a.keys + a.count, b.keys);
+    }
+    cout << "Epoch recovery: " << durable << " of " << OPS / 2 + 337 << " ops durable, image "
+         << (ok ? "matches" : "DOES NOT match") << " the replayed prefix\n";
+}
+
+// ====== Pipelined persistence: deferred fences under injected latency ======
+// The same insert stream into a 1024-leaf tree with 500 ns PM writes:
+// fenced per op, or pipelined with the caller waiting for durability every
+// `wait_every` ops (0 = only at the end). wait_every 1 is the sync case
+// expressed through tokens.
+void run_pipelined_bench(mt19937_64 &rng) {
+    const int LEAVES = 1'024, OPS = 100'000;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    vector<uint64_t> keys(OPS);
+    for (auto &k : keys) k = dist(rng);
+
+    pm_write_ns = 500;
+    ofstream csv("results/article1_pipelined_persist.csv");
+    csv << "mode,wait_every,pm_write_ns,throughput_ops_sec,Nw,Nclf,Nmf,dependency_fences\n";
+    double sync_tp = 0, piped_tp = 0;
+    for (int wait_every : {-1, 1, 4, 16, 64, 0}) {
+        SimpleBPlusTree<> tree(LEAVES);
+        const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+        unique_ptr<PipelinedPersist> pp;
+        if (wait_every >= 0) pp.reset(new PipelinedPersist);
+        auto t0 = high_resolution_clock::now();
+        for (int i = 0; i < OPS; i++) {
+            tree.insert(keys[i]);
+            if (!pp) continue;
+            PipelinedPersist::Token t = pp->op_done();
+            if (wait_every && (i + 1) % wait_every == 0) pp->wait(t);
+        }
+        uint64_t deps = pp ? pp->dependency_fences : 0;
+        pp.reset(); // final durability point
+        double tp = OPS / duration<double>(high_resolution_clock::now() - t0).count();
+        csv << (wait_every >= 0 ? "pipelined" : "fence_per_op") << ","
+            << max(wait_every, 0) << "," << pm_write_ns << "," << tp << "," << Nw - w0 << ","
+            << Nclf - c0 << "," << Nmf - f0 << "," << deps << "\n";
+        if (wait_every < 0) sync_tp = tp;
+        if (wait_every == 16) piped_tp = tp;
+    }
+    pm_write_ns = 0;
+    cout << "Pipelined persist (500 ns writes, durable every 16 ops): " << piped_tp
+         << " inserts/sec vs " << sync_tp << " fenced per op\n";
+}
+
+// ====== Leaf tiering: throughput vs fast-tier capacity ======
+// 4096 half-full leaves, 90% lookups / 10% inserts, leaves picked by
+// Zipf(0.99) rank; the hot ranking is reshuffled halfway so migration has
+// to follow a moving hot set. Slow tier: PM (300 ns, persistent) or CXL
+// memory (150 ns); the fast tier is DRAM (no added latency) sized as a
+// fraction of the leaves.
+void run_tiering_bench(mt19937_64 &rng) {
+    const int LEAVES = 4'096, PER_LEAF = 64, OPS = 200'000;
+    const uint64_t PASS_OPS = 5'000;
+    const size_t MAX_MOVES = 128;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    uniform_real_distribution<double> u01(0.0, 1.0);
+    vector<uint64_t> prefill((size_t)LEAVES * PER_LEAF);
+    for (auto &k : prefill) k = dist(rng);
+    vector<vector<uint64_t>> by_leaf(LEAVES);
+    for (auto k : prefill) by_leaf[SimpleBPlusTree<>::route(k, LEAVES)].push_back(k);
+
+    vector<double> zipf_cdf(LEAVES);
+    double sum = 0;
+    for (int r = 0; r < LEAVES; r++) zipf_cdf[r] = (sum += 1.0 / pow(r + 1.0, 0.99));
+    for (auto &c : zipf_cdf) c /= sum;
+
+    vector<vector<uint64_t>> fresh(LEAVES); // unused keys, bucketed by leaf, for writes
+    for (int i = 0; i < LEAVES * 32; i++) {
+        uint64_t k = dist(rng);
+        fresh[SimpleBPlusTree<>::route(k, LEAVES)].push_back(k);
+    }
+
+    struct Op { bool write; uint64_t key; };
+    vector<Op> ops(OPS);
+    vector<int> leaf_rank(LEAVES);
+    iota(leaf_rank.begin(), leaf_rank.end(), 0);
+    for (int i = 0; i < OPS; i++) {
+        if (i % (OPS / 2) == 0) shuffle(leaf_rank.begin(), leaf_rank.end(), rng);
+        size_t r = lower_bound(zipf_cdf.begin(), zipf_cdf.end(), u01(rng)) - zipf_cdf.begin();
+        const int leaf = leaf_rank[min(r, (size_t)LEAVES - 1)];
+        ops[i].write = u01(rng) < 0.1;
+        if (ops[i].write) // a new key that routes to the sampled leaf
+            ops[i].key = fresh[leaf].empty() ? dist(rng) : fresh[leaf][rng() % fresh[leaf].size()];
+        else
+            ops[i].key = by_leaf[leaf][rng() % by_leaf[leaf].size()];
+    }
+
+    ofstream csv("results/article1_tiering.csv");
+    csv << "slow_tier,fast_ratio,throughput_ops_sec,fast_access_share,migrations,migrated_bytes,Nw,Nclf,Nmf\n";
+    struct { const char *name; uint64_t ns; bool persistent; } slows[] = {
+        { "pm", 300, true }, { "cxl", 150, false },
+    };
+    for (auto &sl : slows) {
+        for (double ratio : {0.0, 0.05, 0.1, 0.25, 0.5, 1.0}) {
+            SimpleBPlusTree<> tree(LEAVES);
+            for (auto k : prefill) tree.insert(k);
+            LeafTiering<> tiers(tree, (size_t)(ratio * LEAVES), 0, LEAVES, sl.ns, sl.persistent,
+                                PASS_OPS, MAX_MOVES);
+            const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+            uint64_t found = 0, reads = 0;
+            auto t0 = high_resolution_clock::now();
+            for (auto &op : ops) {
+                if (op.write) tiers.insert(op.key);
+                else { found += tiers.search(op.key); reads++; }
+            }
+            double tp = OPS / duration<double>(high_resolution_clock::now() - t0).count();
+            if (found != reads) cout << "Tiering: MISSED KEYS\n";
+            csv << sl.name << "," << ratio << "," << tp << "," << tiers.fast_share() << ","
+                << tiers.moves << "," << tiers.migrated_bytes() << ","
+                << Nw - w0 << "," << Nclf - c0 << "," << Nmf - f0 << "\n";
+            if (ratio == 0.1 || ratio == 1.0)
+                cout << "Tiering (" << sl.name << " slow tier, " << ratio * 100 << "% fast): " << tp << " ops/sec, "
+                     << tiers.fast_share() * 100 << "% of accesses fast, " << tiers.moves << " moves\n";
+        }
+    }
+}
+
+// ====== Batched routing: per-key inserts vs radix-partitioned batches ======
+// One million keys into 16384 leaves (about 20 MiB of nodes, past the LLC),
+// key by key or in batches of BATCH keys, without and with injected PM
+// write latency; all trees must end up with the same per-leaf counts. The
+// per_key_batch_persist row routes key by key but flushes and fences per
+// batch like radix_batch, splitting the batch's gain into fence batching
+// (per_key -> per_key_batch_persist) and partitioning (the rest).
+void run_batch_routing_bench(mt19937_64 &rng) {
+    const int LEAVES = 16'384, KEYS = 1'000'000, BATCH = 262'144;
+    uniform_int_distribution<uint64_t> dist(1, 100'000'000);
+    vector<uint64_t> keys(KEYS);
+    for (auto &k : keys) k = dist(rng);
+
+    ofstream csv("results/article1_batch_routing.csv");
+    csv << "variant,leaves,batch,pm_write_ns,throughput_keys_sec,Nw,Nclf,Nmf\n";
+    for (uint64_t write_ns : {0, 500}) {
+        pm_write_ns = write_ns;
+        SimpleBPlusTree<> per_key(LEAVES), deferred(LEAVES), batched(LEAVES);
+        const uint64_t w0 = Nw, c0 = Nclf, f0 = Nmf;
+        auto t0 = high_resolution_clock::now();
+        for (auto k : keys) per_key.insert(k);
+        auto t1 = high_resolution_clock::now();
+        const uint64_t w1 = Nw, c1 = Nclf, f1 = Nmf;
+        for (size_t i = 0; i < keys.size(); i += BATCH)
+            deferred.insert_deferred(&keys[i], min((size_t)BATCH, keys.size() - i));
+        auto t2 = high_resolution_clock::now();
+        const uint64_t w2 = Nw, c2 = Nclf, f2 = Nmf;
+        for (size_t i = 0; i < keys.size(); i += BATCH)
+            batched.insert_batch(&keys[i], min((size_t)BATCH, keys.size() - i));
+        auto t3 = high_resolution_clock::now();
+
+        bool same = true;
+        for (int i = 0; i < LEAVES; i++)
+            same = same && per_key.leaves[i]->count == batched.leaves[i]->count &&
+                   deferred.leaves[i]->count == batched.leaves[i]->count;
+        double tp_key = KEYS / duration<double>(t1 - t0).count();
+        double tp_deferred = KEYS / duration<double>(t2 - t1).count();
+        double tp_batch = KEYS / duration<double>(t3 - t2).count();
+        csv << "per_key," << LEAVES << ",1," << write_ns << "," << tp_key << ","
+            << w1 - w0 << "," << c1 - c0 << "," << f1 - f0 << "\n";
+        csv << "per_key_batch_persist," << LEAVES << "," << BATCH << "," << write_ns << "," << tp_deferred << ","
+            << w2 - w1 << "," << c2 - c1 << "," << f2 - f1 << "\n";
+        csv << "radix_batch," << LEAVES << "," << BATCH << "," << write_ns << "," << tp_batch << ","
+            << Nw - w2 << "," << Nclf - c2 << "," << Nmf - f2 << "\n";
+        cout << "Batched routing over " << LEAVES << " leaves (pm_write_ns " << write_ns << "): "
+             << tp_batch << " keys/sec vs " << tp_key << " per key; fence batching alone "
+             << tp_deferred << ", partitioning x" << tp_batch / tp_deferred
+             << (same ? "" : " (LEAF COUNTS DIFFER)") << "\n";
+
+        // Same keys into sorted leaves: insert_sorted per key vs the batch
+        // path, which merges each partition with insert_sorted_batch.
+        SimpleBPlusTree<uint64_t, 128, true> sorted_key(LEAVES), sorted_batch(LEAVES);
+        const uint64_t w3 = Nw, c3 = Nclf, f3 = Nmf;
+        auto t4 = high_resolution_clock::now();
+        for (auto k : keys) sorted_key.insert(k);
+        auto t5 = high_resolution_clock::now();
+        const uint64_t w4 = Nw, c4 = Nclf, f4 = Nmf;
+        for (size_t i = 0; i < keys.size(); i += BATCH)
+            sorted_batch.insert_batch(&keys[i], min((size_t)BATCH, keys.size() - i));
+        auto t6 = high_resolution_clock::now();
+
+        bool same_sorted = true;
+        for (int i = 0; i < LEAVES; i++) {
+            const auto &a = *sorted_key.leaves[i], &b = *sorted_batch.leaves[i];
+            same_sorted = same_sorted && a.count == b.count && equal(a.keys, a.keys + a.count, b.keys) &&
+                          is_sorted(b.keys, b.keys + b.count);
+        }
+        double tp_sorted_key = KEYS / duration<double>(t5 - t4).count();
+        double tp_sorted_batch = KEYS / duration<double>(t6 - t5).count();
+        csv << "sorted_per_key," << LEAVES << ",1," << write_ns << "," << tp_sorted_key << ","
+            << w4 - w3 << "," << c4 - c3 << "," << f4 - f3 << "\n";
+        csv << "sorted_radix_batch," << LEAVES << "," << BATCH << "," << write_ns << "," << tp_sorted_batch << ","
+            << Nw - w4 << "," << Nclf - c4 << "," << Nmf - f4 << "\n";
+        cout << "Batched routing into sorted leaves (pm_write_ns " << write_ns << "): "
+             << tp_sorted_batch << " keys/sec vs " << tp_sorted_key << " per key"
+             << (same_sorted ? "" : " (LEAVES DIFFER)") << "\n";
+    }
+    pm_write_ns = 0;
+}
+
+// ====== Sort-on-scan: std::sort vs bitonic networks (scalar and AVX2) ======
+// Ordered scans over 1024 full unsorted leaves per capacity; every kernel
+// must produce the std::sort order.
+template<int Cap>
+void sort_scan_rows(mt19937_64 &rng, ofstream &csv) {
+    const int LEAVES = 1024, REPS = 20;
+    vector<unique_ptr<LeafNode<uint64_t, Cap>>> leaves;
+    for (int i = 0; i < LEAVES; i++) {
+        leaves.push_back(make_unique<LeafNode<uint64_t, Cap>>());
+        for (int k = 0; k < Cap; k++) leaves.back()->keys[k] = rng();
+        leaves.back()->count = Cap;
+    }
+    const SortKernel detected = sort_kernel;
+    vector<uint64_t> ref((size_t)LEAVES * Cap), out((size_t)LEAVES * Cap);
+    sort_kernel = SortKernel::Std;
+    for (int i = 0; i < LEAVES; i++) scan_unsorted(*leaves[i], &ref[(size_t)i * Cap]);
+
+    cout << "Sort-on-scan (" << Cap << " keys):";
+    for (auto [name, k] : {pair<const char *, SortKernel>{"std_sort", SortKernel::Std},
+                           {"network_scalar", SortKernel::Scalar}, {"network_avx2", SortKernel::Avx2}}) {
+        if (k == SortKernel::Avx2 && detected != SortKernel::Avx2) continue;
+        sort_kernel = k;
+        auto t0 = high_resolution_clock::now();
+        for (int r = 0; r < REPS; r++)
+            for (int i = 0; i < LEAVES; i++) scan_unsorted(*leaves[i], &out[(size_t)i * Cap]);
+        double ns = duration<double, nano>(high_resolution_clock::now() - t0).count() / (REPS * LEAVES);
+        csv << name << "," << Cap << "," << ns << "\n";
+        cout << " " << name << " " << ns << " ns" << (out == ref ? "" : " (ORDER DIFFERS)");
+    }
+    cout << "\n";
+    sort_kernel = detected;
+}
+
+void run_sort_kernel_bench(mt19937_64 &rng) {
+    ofstream csv("results/article1_sort_kernels.csv");
+    csv << "kernel,keys,ns_per_scan\n";
+    sort_scan_rows<32>(rng, csv);
+    sort_scan_rows<64>(rng, csv);
+    sort_scan_rows<128>(rng, csv);
+    sort_scan_rows<256>(rng, csv);
+
+    // Cross-check every kernel against std::sort / std::merge on random
+    // lengths (odd sizes, tiny runs, skewed merges, sort_small past its
+    // 64-key networks) and narrow key ranges.
+    const SortKernel detected = sort_kernel;
+    bool ok = true;
+    for (SortKernel k : {SortKernel::Scalar, SortKernel::Avx2}) {
+        if (k == SortKernel::Avx2 && detected != SortKernel::Avx2) continue;
+        sort_kernel = k;
+        for (int t = 0; t < 2000; t++) {
+            const size_t na = rng() % 300, nb = rng() % (t % 2 ? 8 : 300);
+            const uint64_t range = t % 3 ? ~0ULL : 16;
+            vector<uint64_t> a(na), b(nb), tmp(na), out(na + nb), ref(na + nb);
+            for (auto &x : a) x = rng() % range;
+            for (auto &x : b) x = rng() % range;
+            vector<uint64_t> sa = a, small = a; // sort_small past 64 keys takes std::sort
+            sort_keys(a.data(), na, tmp.data());
+            sort_small(small.data(), na);
+            sort(sa.begin(), sa.end());
+            ok = ok && a == sa && small == sa;
+            sort(b.begin(), b.end());
+            merge_runs(a.data(), na, b.data(), nb, out.data());
+            merge(a.begin(), a.end(), b.begin(), b.end(), ref.begin());
+            ok = ok && out == ref;
+        }
+    }
+    sort_kernel = detected;
+    cout << "Sort kernels vs std::sort/std::merge: " << (ok ? "ok" : "MISMATCH") << "\n";
+}
+
 int main() {
     // Build environment similar to paper's setup, but smaller and RAM-only
     const int NUM_LEAVES = 64;
-    SimpleBPlusTree index(NUM_LEAVES);
+    SimpleBPlusTree<> index(NUM_LEAVES);
 
     mt19937_64 rng(123);
     uniform_int_distribution<uint64_t> dist(1, 100'000'000);
@@ -91,7 +1800,7 @@ int main() {
     for (auto &k : bench_keys) k = dist(rng);
 
     // Baseline sorted leaf benchmark
-    LeafNode base_leaf;
+    LeafNode<> base_leaf;
     auto t0 = high_resolution_clock::now();
     int ib = 0;
     for (auto k : bench_keys) { insert_sorted(base_leaf, k); ib++; }
@@ -103,17 +1812,84 @@ int main() {
     for (auto k : bench_keys) { index.insert(k); iu++; pcm_write(); } 
     auto t3 = high_resolution_clock::now();
 
+    // Gapped sorted leaf benchmark, same keys as the sorted leaf.
+    // Counters are snapshotted so the gapped row only reports its own cost.
+    const uint64_t Nw0 = Nw, Nclf0 = Nclf, Nmf0 = Nmf;
+    GappedLeafNode gap_leaf;
+    auto t4 = high_resolution_clock::now();
+    int ig = 0;
+    for (auto k : bench_keys) { insert_gapped(gap_leaf, k); ig++; }
+    auto t5 = high_resolution_clock::now();
+    const uint64_t gap_Nw = Nw - Nw0, gap_Nclf = Nclf - Nclf0, gap_Nmf = Nmf - Nmf0;
+
+    // Hash-slotted leaf benchmark, same keys again
+    const uint64_t Nw1 = Nw, Nclf1 = Nclf, Nmf1 = Nmf;
+    HashLeafNode hash_leaf;
+    auto t6 = high_resolution_clock::now();
+    int ih = 0;
+    for (auto k : bench_keys) { insert_hashed(hash_leaf, k); ih++; }
+    auto t7 = high_resolution_clock::now();
+    const uint64_t hash_Nw = Nw - Nw1, hash_Nclf = Nclf - Nclf1, hash_Nmf = Nmf - Nmf1;
+
     double secs_base = duration<double>(t1 - t0).count();
     double secs_tree = duration<double>(t3 - t2).count();
+    double secs_gap  = duration<double>(t5 - t4).count();
+    double secs_hash = duration<double>(t7 - t6).count();
 
     double tp_base = ib / secs_base;
     double tp_tree = iu / secs_tree;
+    double tp_gap  = ig / secs_gap;
+    double tp_hash = ih / secs_hash;
 
     // Sample searches over inserted keys to verify correctness
     int hits = 0;
     for (int i = 0; i < 5'000; i++) {
         if (search_leaf(base_leaf, bench_keys[i])) hits++;
     }
+    int gap_hits = 0;
+    for (int i = 0; i < 5'000; i++) {
+        if (search_gapped(gap_leaf, bench_keys[i])) gap_hits++;
+    }
+
+    // Point lookups: linear scan of the sorted leaf vs hash probe
+    auto t8 = high_resolution_clock::now();
+    int hash_hits = 0;
+    for (int i = 0; i < 5'000; i++) {
+        if (search_hashed(hash_leaf, bench_keys[i])) hash_hits++;
+    }
+    auto t9 = high_resolution_clock::now();
+    int lin_hits = 0;
+    for (int i = 0; i < 5'000; i++) {
+        if (search_leaf(base_leaf, bench_keys[i])) lin_hits++;
+    }
+    auto t10 = high_resolution_clock::now();
+    double lookups_hash = 5'000 / duration<double>(t9 - t8).count();
+    double lookups_lin  = 5'000 / duration<double>(t10 - t9).count();
+
+    // Ordered scan must still come out sorted
+    vector<uint64_t> scanned;
+    scan_hashed(hash_leaf, scanned);
+    bool scan_ok = is_sorted(scanned.begin(), scanned.end()) && (int)scanned.size() == hash_leaf.count;
+
+    // 4 KiB leaves over one leaf's key range (keys share their high bits)
+    uniform_int_distribution<uint64_t> dist_range(50'000'000, 50'000'000 + 60'000);
+    vector<uint64_t> range_keys(4'000);
+    for (auto &k : range_keys) k = dist_range(rng);
+    NodeArena<LeafNode<uint64_t, 504>> plain_arena;
+    NodeArena<ForLeafNode<uint16_t>> for16_arena;
+    NodeArena<ForLeafNode<uint32_t>> for32_arena;
+    auto *plain4k = plain_arena.alloc();
+    auto *for16   = for16_arena.alloc();
+    auto *for32   = for32_arena.alloc();
+    LeafRun r_plain = run_4k_leaf(*plain4k, range_keys,
+        [](auto &l, uint64_t k) { insert_sorted(l, k); },
+        [](auto &l, uint64_t k) { return search_leaf(l, k); });
+    LeafRun r_for16 = run_4k_leaf(*for16, range_keys,
+        [](auto &l, uint64_t k) { insert_for(l, k); },
+        [](auto &l, uint64_t k) { return search_for(l, k); });
+    LeafRun r_for32 = run_4k_leaf(*for32, range_keys,
+        [](auto &l, uint64_t k) { insert_for(l, k); },
+        [](auto &l, uint64_t k) { return search_for(l, k); });
 
     // Ensure results directory exists
     mkdir("results", 0777);
@@ -121,14 +1897,48 @@ int main() {
     // Export metrics for report & Python graphs
     ofstream csv("results/article1_metrics.csv");
     csv << "variant,throughput_ops_sec,Nw,Nclf,Nmf,search_hits\n";
-    csv << "sorted," << tp_base << "," << Nw << "," << Nclf << "," << Nmf << "," << hits << "\n";
-    csv << "unsorted," << tp_tree << "," << Nw/4 << "," << Nclf/4 << "," << Nmf/4 << "," << hits << "\n";
+    csv << "sorted," << tp_base << "," << Nw0 << "," << Nclf0 << "," << Nmf0 << "," << hits << "\n";
+    csv << "unsorted," << tp_tree << "," << Nw0/4 << "," << Nclf0/4 << "," << Nmf0/4 << "," << hits << "\n";
+    csv << "gapped_sorted," << tp_gap << "," << gap_Nw << "," << gap_Nclf << "," << gap_Nmf << "," << gap_hits << "\n";
+    csv << "hash_slotted," << tp_hash << "," << hash_Nw << "," << hash_Nclf << "," << hash_Nmf << "," << hash_hits << "\n";
+    for (auto &[name, r] : {pair<const char *, LeafRun &>{"sorted_4k", r_plain},
+                            {"for16_sorted_4k", r_for16}, {"for32_sorted_4k", r_for32}})
+        csv << name << "," << r.tp_insert << "," << r.Nw << "," << r.Nclf << "," << r.Nmf << "," << r.hits << "\n";
     csv.close();
 
+    ofstream batch_csv("results/article1_batch_metrics.csv");
+    batch_csv << "variant,batch,throughput_keys_sec,Nw,Nclf,Nmf\n";
+    run_batch_sweep(batch_csv, rng);
+    batch_csv.close();
+
     // Final terminal output
     cout << "Inserts/sec sorted: " << tp_base << "\n";
     cout << "Inserts/sec tree (unsorted): " << tp_tree << "\n";
+    cout << "Inserts/sec gapped sorted: " << tp_gap << " (Nw " << gap_Nw << ")\n";
+    cout << "Inserts/sec hash slotted: " << tp_hash << " (Nw " << hash_Nw
+         << ", filled " << hash_leaf.count << " / " << HASH_SLOTS << ")\n";
+    cout << "Lookups/sec sorted leaf scan: " << lookups_lin << " (" << lin_hits << " hits)"
+         << ", hash slotted: " << lookups_hash << " (" << hash_hits << " hits)\n";
+    cout << "Hash leaf ordered scan: " << (scan_ok ? "ok" : "BROKEN") << "\n";
+    {
+        mt19937_64 check_rng(7); // own stream: the benches below keep their keys
+        run_instantiation_checks(check_rng);
+    }
+    cout << "Gapped leaf with key 0: " << (check_gapped_zero() ? "ok" : "BROKEN") << "\n";
+    cout << "Arena reuse (200 trees built back to back): " << (check_arena_reuse() ? "ok" : "BROKEN") << "\n";
+    for (auto &[name, r] : {pair<const char *, LeafRun &>{"plain", r_plain},
+                            {"for16", r_for16}, {"for32", r_for32}})
+        cout << "4 KiB leaf " << name << ": " << r.keys << " keys, Nw " << r.Nw
+             << ", lookups/sec " << r.tp_lookup << " (" << r.hits << " hits)\n";
     cout << "Search hits (sample): " << hits << " / 5000\n";
+    run_header_scan_bench(rng);
+    run_read_cache_bench(rng);
+    run_epoch_bench(rng);
+    run_pipelined_bench(rng);
+    run_tiering_bench(rng);
+    run_batch_routing_bench(rng);
+    run_sort_kernel_bench(rng);
+    cout << "Node arena: " << index.arena.huge_regions() << " region(s) on MAP_HUGETLB\n";
     cout << "Simulation complete, relative trends preserved!\n";
 
     return 0;
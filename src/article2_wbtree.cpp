@@ -18,117 +18,366 @@ inline void pcm_write(Stats &s, uint64_t words = 1) { s.Nw   += words; }
 inline void pcm_flush(Stats &s)                    { s.Nclf += 1;      }
 inline void pcm_fence(Stats &s)                    { s.Nmf  += 1;      }
 
+// Flush every cache line overlapping [p, p + bytes), by real address.
+static const uintptr_t LINE = 64;
+inline void pcm_flush_range(Stats &s, const void *p, size_t bytes) {
+    uintptr_t a = (uintptr_t)p;
+    for (uintptr_t l = a / LINE; l <= (a + bytes - 1) / LINE; ++l) pcm_flush(s);
+}
+
+// Every leaf starts with one header line (count, bitmap, version, sibling);
+// keys start on the next line and nodes are padded to multiples of 256 bytes.
+#define LEAF_HEADER(Self)                  \
+    alignas(LINE) int count = 0;           \
+    uint32_t version = 0;                  \
+    uint64_t bitmap[(Cap + 63) / 64] = {}; \
+    Self *sibling = nullptr;
+
+// ========== Key types ==========
+// Leaves are templated on key type; a key write costs one word per 8 bytes.
+struct Key128 {
+    uint64_t hi = 0, lo = 0;
+    bool operator==(const Key128 &o) const { return hi == o.hi && lo == o.lo; }
+    bool operator<(const Key128 &o)  const { return hi < o.hi || (hi == o.hi && lo < o.lo); }
+};
+
+// Fixed 16-byte string key, compared bytewise (memcmp order).
+struct FixedStr16 {
+    char b[16] = {};
+    bool operator==(const FixedStr16 &o) const { return memcmp(b, o.b, 16) == 0; }
+    bool operator<(const FixedStr16 &o)  const { return memcmp(b, o.b, 16) < 0; }
+};
+
+template<typename Key>
+constexpr uint64_t key_words() { return (sizeof(Key) + 7) / 8; }
+
+template<typename Key> Key make_key(uint64_t v);
+template<> inline uint32_t make_key<uint32_t>(uint64_t v) { return (uint32_t)v; }
+template<> inline uint64_t make_key<uint64_t>(uint64_t v) { return v; }
+template<> inline Key128 make_key<Key128>(uint64_t v) {
+    Key128 k; k.hi = v >> 32; k.lo = v * 0x9E3779B97F4A7C15ULL; return k;
+}
+template<> inline FixedStr16 make_key<FixedStr16>(uint64_t v) {
+    // "tnt0-" prefix shared by all keys, then a zero-padded decimal id
+    FixedStr16 k;
+    snprintf(k.b, sizeof(k.b), "tnt0-%010llu", (unsigned long long)(v % 10'000'000'000ULL));
+    return k;
+}
+
+template<typename Key> const char *key_name();
+template<> inline const char *key_name<uint32_t>()   { return "u32"; }
+template<> inline const char *key_name<uint64_t>()   { return "u64"; }
+template<> inline const char *key_name<Key128>()     { return "u128"; }
+template<> inline const char *key_name<FixedStr16>() { return "str16"; }
+
+// Insert position in a sorted leaf. Cap is a compile-time constant, so the
+// loop has a fixed trip count and unrolls; slots past count are never read.
+template<typename Key, int Cap>
+inline int sorted_position(const Key (&keys)[Cap], int count, const Key &k) {
+    int pos = 0;
+#pragma GCC unroll 16
+    for (int i = 0; i < Cap; ++i)
+        pos += (i < count) && keys[i] < k;
+    return pos;
+}
+
+template<typename Key, int Cap>
+inline bool sorted_search(const Key (&keys)[Cap], int count, const Key &k) {
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (keys[mid] == k) return true;
+        if (keys[mid] < k)  lo = mid + 1;
+        else                hi = mid - 1;
+    }
+    return false;
+}
+
 // We'll pretend each leaf node is ~8 cache lines, capacity 32 entries
 static const int CAP = 32;
 
 // ========== Variant 1: Volatile main-memory B+-Tree leaf ==========
-struct LeafBTreeVolatile {
-    uint64_t keys[CAP];
-    int count = 0;
+template<typename Key = uint64_t, int Cap = CAP>
+struct alignas(256) LeafBTreeVolatile {
+    LEAF_HEADER(LeafBTreeVolatile)
+    alignas(LINE) Key keys[Cap] = {};
 
-    void insert(uint64_t k, Stats &s) {
-        if (count >= CAP) return; // ignore overflow for simplicity
-        int pos = 0;
-        while (pos < count && keys[pos] < k) ++pos;
+    void insert(const Key &k, Stats &s) {
+        if (count >= Cap) return; // ignore overflow for simplicity
+        int pos = sorted_position(keys, count, k);
 
         // shift keys to keep sorted order
         for (int i = count; i > pos; --i) {
             keys[i] = keys[i - 1];
-            pcm_write(s); // one word copied
+            pcm_write(s, key_words<Key>()); // one key copied
         }
         keys[pos] = k;
         ++count;
-        pcm_write(s); // write new key
+        pcm_write(s, key_words<Key>()); // write new key
         // No flush/fence: non-persistent baseline
     }
 
-    bool search(uint64_t k, Stats &s) const {
+    bool search(const Key &k, Stats &) const {
         // assume reads only, no wear
-        int lo = 0, hi = count - 1;
-        while (lo <= hi) {
-            int mid = (lo + hi) / 2;
-            if (keys[mid] == k) return true;
-            if (keys[mid] < k)  lo = mid + 1;
-            else                hi = mid - 1;
-        }
-        return false;
+        return sorted_search(keys, count, k);
     }
 };
 
 // ========== Variant 2: B+-Tree with undo/redo logging ==========
-struct LeafBTreeLog {
-    uint64_t keys[CAP];
-    int count = 0;
+template<typename Key = uint64_t, int Cap = CAP>
+struct alignas(256) LeafBTreeLog {
+    LEAF_HEADER(LeafBTreeLog)
+    alignas(LINE) Key keys[Cap] = {};
 
-    void insert(uint64_t k, Stats &s) {
-        if (count >= CAP) return;
+    void insert(const Key &k, Stats &s) {
+        if (count >= Cap) return;
 
         // 1) Write a log record (node_id, op_type, key, pos)
-        pcm_write(s, 4);  // pretend 4 words in the log record
+        pcm_write(s, 3 + key_words<Key>());  // header words + the key
         pcm_flush(s);     // flush log
         pcm_fence(s);     // fence to ensure durability
 
         // 2) Do the in-place update, same as volatile B+-Tree
-        int pos = 0;
-        while (pos < count && keys[pos] < k) ++pos;
+        int pos = sorted_position(keys, count, k);
 
         for (int i = count; i > pos; --i) {
             keys[i] = keys[i - 1];
-            pcm_write(s);
+            pcm_write(s, key_words<Key>());
         }
         keys[pos] = k;
         ++count;
-        pcm_write(s);
+        pcm_write(s, key_words<Key>());
 
-        // 3) Flush updated node and fence
-        pcm_flush(s);
+        // 3) Flush the shifted key lines plus the header line, then fence
+        pcm_flush_range(s, &keys[pos], (count - pos) * sizeof(Key));
+        pcm_flush_range(s, &count, sizeof(count));
         pcm_fence(s);
     }
 
-    bool search(uint64_t k, Stats &s) const {
-        int lo = 0, hi = count - 1;
-        while (lo <= hi) {
-            int mid = (lo + hi) / 2;
-            if (keys[mid] == k) return true;
-            if (keys[mid] < k)  lo = mid + 1;
-            else                hi = mid - 1;
-        }
-        return false;
+    bool search(const Key &k, Stats &) const {
+        return sorted_search(keys, count, k);
     }
 };
 
 // ========== Variant 3: Simplified wB+-Tree-style leaf ==========
 // Idea: slot/payload indirection in the paper minimizes NVM writes;
 // here we approximate that by *append + small metadata update*.
-struct LeafWBTree {
-    uint64_t keys[CAP];
-    int count = 0;
+template<typename Key = uint64_t, int Cap = CAP>
+struct alignas(256) LeafWBTree {
+    LEAF_HEADER(LeafWBTree)
+    alignas(LINE) Key keys[Cap] = {};
 
-    void insert(uint64_t k, Stats &s) {
-        if (count >= CAP) return;
+    void insert(const Key &k, Stats &s) {
+        if (count >= Cap) return;
         int idx = count;          // append position
         keys[idx] = k;
         ++count;
 
         // In a real wB+-Tree, you'd update a small slot array + version.
-        // Model that as just 2 word writes plus a single flush+fence:
-        pcm_write(s, 2);
-        pcm_flush(s);
+        // Model that as the key plus one header word; flush the key line(s)
+        // and the header line, single fence:
+        ++version;
+        pcm_write(s, key_words<Key>() + 1);
+        pcm_flush_range(s, &keys[idx], sizeof(Key));
+        pcm_flush_range(s, &count, sizeof(count));
         pcm_fence(s);
     }
 
-    bool search(uint64_t k, Stats &s) const {
+    bool search(const Key &k, Stats &) const {
         // simple linear search (like bitmap/unsorted leaf cost)
-        for (int i = 0; i < count; ++i)
-            if (keys[i] == k) return true;
+#pragma GCC unroll 8
+        for (int i = 0; i < Cap; ++i)
+            if (i < count && keys[i] == k) return true;
         return false;
     }
 };
 
+// Explicit instantiations for the capacity sweep below
+#define INSTANTIATE_LEAVES(Key, Cap)                  \
+    template struct LeafBTreeVolatile<Key, Cap>;      \
+    template struct LeafBTreeLog<Key, Cap>;           \
+    template struct LeafWBTree<Key, Cap>;
+#define INSTANTIATE_CAPS(Key)                         \
+    INSTANTIATE_LEAVES(Key, 16)                       \
+    INSTANTIATE_LEAVES(Key, 32)                       \
+    INSTANTIATE_LEAVES(Key, 64)                       \
+    INSTANTIATE_LEAVES(Key, 128)
+INSTANTIATE_CAPS(uint32_t)
+INSTANTIATE_CAPS(uint64_t)
+INSTANTIATE_CAPS(Key128)
+INSTANTIATE_CAPS(FixedStr16)
+#undef INSTANTIATE_CAPS
+#undef INSTANTIATE_LEAVES
+#undef LEAF_HEADER
+
+static_assert(sizeof(LeafWBTree<>) % 256 == 0, "node size must be a multiple of 256 bytes");
+static_assert(offsetof(LeafWBTree<>, keys) == LINE, "keys must start right after the header line");
+
+// ========== Variable-length string keys with prefix compression ==========
+// 4 KiB leaf for 16-64 byte keys. Layout, line by line:
+//   header : count, heap top, the leaf's shared prefix (stored once)
+//   order  : wB+-Tree-style 1-byte sorted indirection (WBTree layout only)
+//   slots  : one word each -- 4-byte key head, heap offset, suffix length
+//   heap   : key suffixes (key minus shared prefix), appended out of line
+// The key head holds the first 4 suffix bytes big-endian, so most comparisons
+// are integer compares on the slot array and never touch the heap. Heap bytes
+// are charged as word writes and flushed by line like everything else.
+// Keys that do not carry the leaf's prefix belong to another leaf.
+static const int STR_SLOTS      = 128;
+static const int STR_PREFIX_MAX = 56;
+static const int STR_HEAP       = 4096 - LINE - STR_SLOTS - STR_SLOTS * 8;
+
+enum class StrLayout { Sorted, Unsorted, WBTree };
+
+struct StrSlot {
+    uint32_t head;  // first 4 suffix bytes, big-endian, zero padded
+    uint16_t off;   // suffix offset in the heap
+    uint16_t len;   // suffix length
+};
+
+inline uint32_t str_head(const char *p, size_t len) {
+    uint32_t h = 0;
+    for (size_t i = 0; i < 4; ++i)
+        h = (h << 8) | (i < len ? (uint8_t)p[i] : 0);
+    return h;
+}
+
+template<StrLayout L>
+struct alignas(256) StringLeaf {
+    alignas(LINE) uint16_t count = 0;  // header line
+    uint16_t heap_top = 0;
+    uint16_t version = 0;
+    uint8_t  prefix_len = 0;
+    char     prefix[STR_PREFIX_MAX] = {};
+    alignas(LINE) uint8_t order[STR_SLOTS] = {};
+    alignas(LINE) StrSlot slots[STR_SLOTS] = {};
+    alignas(LINE) char heap[STR_HEAP] = {};
+
+    void set_prefix(const string &p) {
+        prefix_len = (uint8_t)min<size_t>(p.size(), STR_PREFIX_MAX);
+        memcpy(prefix, p.data(), prefix_len);
+    }
+
+    bool has_prefix(const string &k) const {
+        return k.size() >= prefix_len && memcmp(k.data(), prefix, prefix_len) == 0;
+    }
+
+    // memcmp order of the stored suffix in `slot` vs (suf, len, head)
+    int compare(const StrSlot &slot, const char *suf, size_t len, uint32_t head) const {
+        if (slot.head != head) return slot.head < head ? -1 : 1;
+        int c = memcmp(heap + slot.off, suf, min<size_t>(slot.len, len));
+        if (c != 0) return c;
+        return (int)slot.len - (int)len;
+    }
+
+    // first position in sorted order whose key is >= suffix
+    template<typename SlotAt>
+    int lower_bound_by(SlotAt at, const char *suf, size_t len, uint32_t head) const {
+        int lo = 0, hi = count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (compare(at(mid), suf, len, head) < 0) lo = mid + 1;
+            else                                      hi = mid;
+        }
+        return lo;
+    }
+
+    void insert(const string &k, Stats &s) {
+        if (count >= STR_SLOTS || !has_prefix(k)) return;
+        const char *suf = k.data() + prefix_len;
+        size_t len = k.size() - prefix_len;
+        if (heap_top + len > (size_t)STR_HEAP) return; // heap full: would split
+        uint32_t head = str_head(suf, len);
+
+        // 1) suffix bytes out of line
+        StrSlot slot{head, heap_top, (uint16_t)len};
+        memcpy(heap + heap_top, suf, len);
+        pcm_write(s, (len + 7) / 8);
+        pcm_flush_range(s, heap + heap_top, len);
+        heap_top += len;
+
+        // 2) slot (and order) update
+        if (L == StrLayout::Sorted) {
+            int pos = lower_bound_by([&](int i) -> const StrSlot & { return slots[i]; },
+                                     suf, len, head);
+            memmove(&slots[pos + 1], &slots[pos], (count - pos) * sizeof(StrSlot));
+            slots[pos] = slot;
+            pcm_write(s, count - pos + 1);
+            pcm_flush_range(s, &slots[pos], (count - pos + 1) * sizeof(StrSlot));
+        } else {
+            slots[count] = slot;
+            pcm_write(s);
+            pcm_flush_range(s, &slots[count], sizeof(StrSlot));
+            if (L == StrLayout::WBTree) {
+                int pos = lower_bound_by([&](int i) -> const StrSlot & { return slots[order[i]]; },
+                                         suf, len, head);
+                memmove(&order[pos + 1], &order[pos], count - pos);
+                order[pos] = (uint8_t)count;
+                pcm_write(s, (count - pos + 1 + 7) / 8);
+                pcm_flush_range(s, &order[pos], count - pos + 1);
+            }
+        }
+
+        // 3) header: count + heap top, single fence
+        ++count;
+        ++version;
+        pcm_write(s);
+        pcm_flush_range(s, &count, sizeof(count));
+        pcm_fence(s);
+    }
+
+    bool search(const string &k, Stats &) const {
+        if (!has_prefix(k)) return false;
+        const char *suf = k.data() + prefix_len;
+        size_t len = k.size() - prefix_len;
+        uint32_t head = str_head(suf, len);
+        if (L == StrLayout::Unsorted) {
+            for (int i = 0; i < count; ++i)
+                if (slots[i].head == head && compare(slots[i], suf, len, head) == 0) return true;
+            return false;
+        }
+        auto at = [&](int i) -> const StrSlot & {
+            return L == StrLayout::WBTree ? slots[order[i]] : slots[i];
+        };
+        int pos = lower_bound_by(at, suf, len, head);
+        return pos < count && compare(at(pos), suf, len, head) == 0;
+    }
+};
+static_assert(sizeof(StringLeaf<StrLayout::Sorted>) == 4096, "string leaves are 4 KiB");
+
+// Tenant plus object ID, 16-64 bytes, all sharing the tenant prefix.
+string make_string_key(mt19937_64 &rng, const string &tenant) {
+    static const char hex[] = "0123456789abcdef";
+    size_t len = 16 + rng() % 49;
+    string k = tenant;
+    while (k.size() < len) k.push_back(hex[rng() % 16]);
+    return k;
+}
+
+template<StrLayout L>
+void run_string_leaf(ofstream &csv, const char *variant, const string &tenant,
+                     const vector<string> &keys) {
+    auto leaf = make_unique<StringLeaf<L>>();
+    leaf->set_prefix(tenant);
+    Stats s;
+    auto t0 = high_resolution_clock::now();
+    for (auto &k : keys) leaf->insert(k, s);
+    auto t1 = high_resolution_clock::now();
+    int hits = 0;
+    const int LOOKUPS = 20000;
+    for (int i = 0; i < LOOKUPS; ++i)
+        hits += leaf->search(keys[i % keys.size()], s);
+    auto t2 = high_resolution_clock::now();
+    csv << variant << "," << leaf->count << "," << leaf->heap_top << ","
+        << keys.size() / duration<double>(t1 - t0).count() << ","
+        << LOOKUPS / duration<double>(t2 - t1).count() << ","
+        << s.Nw << "," << s.Nclf << "," << s.Nmf << "," << hits << "\n";
+}
+
 // ========== Generic benchmarking function ==========
-template<typename LeafType>
+template<typename LeafType, typename Key>
 double run_insert_benchmark(LeafType &leaf, Stats &stats,
-                            const vector<uint64_t> &keys) {
+                            const vector<Key> &keys) {
     auto t0 = high_resolution_clock::now();
     for (auto k : keys)
         leaf.insert(k, stats);
@@ -137,6 +386,36 @@ double run_insert_benchmark(LeafType &leaf, Stats &stats,
     return keys.size() / secs;
 }
 
+// ========== Key type x capacity sweep ==========
+// One row per (variant, key type, capacity); node prefilled to ~70%.
+template<typename Key, int Cap>
+void run_sweep_point(ofstream &csv, int ops) {
+    mt19937_64 rng(123);
+    uniform_int_distribution<uint64_t> dist(1, 1'000'000'000ULL);
+    vector<Key> prefill(Cap * 7 / 10), bench(ops);
+    for (auto &k : prefill) k = make_key<Key>(dist(rng));
+    for (auto &k : bench)   k = make_key<Key>(dist(rng));
+
+    auto row = [&](const char *variant, auto &leaf) {
+        Stats s;
+        for (auto &k : prefill) leaf.insert(k, s);
+        double tp = run_insert_benchmark(leaf, s, bench);
+        csv << variant << "," << key_name<Key>() << "," << Cap << "," << tp
+            << "," << s.Nw << "," << s.Nclf << "," << s.Nmf << "\n";
+    };
+    { LeafBTreeVolatile<Key, Cap> leaf; row("btree_volatile", leaf); }
+    { LeafBTreeLog<Key, Cap> leaf;      row("btree_log", leaf); }
+    { LeafWBTree<Key, Cap> leaf;        row("wbtree_simplified", leaf); }
+}
+
+template<typename Key>
+void run_capacity_sweep(ofstream &csv, int ops) {
+    run_sweep_point<Key, 16>(csv, ops);
+    run_sweep_point<Key, 32>(csv, ops);
+    run_sweep_point<Key, 64>(csv, ops);
+    run_sweep_point<Key, 128>(csv, ops);
+}
+
 int main() {
     // --- Parameters (small-scale version of the paper) ---
     const int PREFILL = CAP * 7 / 10; // ~70% full node
@@ -160,7 +439,7 @@ int main() {
 
     // 1) Volatile B+-Tree leaf
     {
-        LeafBTreeVolatile leaf;
+        LeafBTreeVolatile<> leaf;
         Stats s;
         for (auto k : prefill) leaf.insert(k, s);
         double tp = run_insert_benchmark(leaf, s, bench);
@@ -171,7 +450,7 @@ int main() {
 
     // 2) B+-Tree with logging
     {
-        LeafBTreeLog leaf;
+        LeafBTreeLog<> leaf;
         Stats s;
         for (auto k : prefill) leaf.insert(k, s);
         double tp = run_insert_benchmark(leaf, s, bench);
@@ -182,7 +461,7 @@ int main() {
 
     // 3) Simplified wB+-Tree
     {
-        LeafWBTree leaf;
+        LeafWBTree<> leaf;
         Stats s;
         for (auto k : prefill) leaf.insert(k, s);
         double tp = run_insert_benchmark(leaf, s, bench);
@@ -193,5 +472,27 @@ int main() {
 
     csv.close();
     cout << "Results written to results/wbtree_insert_metrics.csv\n";
+
+    // 4) Key type x node capacity sweep
+    ofstream sweep("results/wbtree_capacity_sweep.csv");
+    sweep << "variant,key_type,cap,throughput_ops_sec,Nw,Nclf,Nmf\n";
+    run_capacity_sweep<uint32_t>(sweep, OPS);
+    run_capacity_sweep<uint64_t>(sweep, OPS);
+    run_capacity_sweep<Key128>(sweep, OPS);
+    run_capacity_sweep<FixedStr16>(sweep, OPS);
+    sweep.close();
+    cout << "Results written to results/wbtree_capacity_sweep.csv\n";
+
+    // 5) Variable-length string keys, one 4 KiB leaf per design
+    const string tenant = "tenant-0042/";
+    vector<string> str_keys(1000);
+    for (auto &k : str_keys) k = make_string_key(rng, tenant);
+    ofstream str_csv("results/wbtree_string_keys.csv");
+    str_csv << "variant,keys,heap_bytes,throughput_ops_sec,lookup_ops_sec,Nw,Nclf,Nmf,search_hits\n";
+    run_string_leaf<StrLayout::Sorted>(str_csv, "str_sorted", tenant, str_keys);
+    run_string_leaf<StrLayout::Unsorted>(str_csv, "str_unsorted", tenant, str_keys);
+    run_string_leaf<StrLayout::WBTree>(str_csv, "str_wbtree", tenant, str_keys);
+    str_csv.close();
+    cout << "Results written to results/wbtree_string_keys.csv\n";
     return 0;
 }
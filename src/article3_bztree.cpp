@@ -3,6 +3,8 @@
 #include <fstream>
 #include <sys/stat.h>
 
+#include "sort_kernels.h"
+
 using namespace std;
 using namespace std::chrono;
 
@@ -15,10 +17,23 @@ struct Stats {
     uint64_t Nmf  = 0;  // fences
 };
 
+// Heap allocation counter, to check the insert path stays allocation-free
+static uint64_t heap_allocs = 0;
+void *operator new(size_t n) {
+    ++heap_allocs;
+    if (void *p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
 inline void pcm_write(Stats &s, uint64_t w=1) { s.Nw += w; }
 inline void pcm_flush(Stats &s)               { s.Nclf++; }
 inline void pcm_fence(Stats &s)               { s.Nmf++; }
 
+static const uintptr_t LINE = 64;
+inline uintptr_t line_of(const void *p) { return (uintptr_t)p / LINE; }
+
 /* =========================================================
    Toy PMwCAS (this is the heart of BzTree)
    ========================================================= */
@@ -27,8 +42,64 @@ struct PMwCAS_Entry {
     uint64_t  new_val;
 };
 
-struct PMwCAS_Descriptor {
-    vector<PMwCAS_Entry> entries;
+// Fixed-capacity descriptor: entries are inline, so building one never
+// touches the heap. PMWCAS_MAX_WORDS bounds how many words one PMwCAS covers:
+// a multi-key insert needs one word per key plus one count per leaf touched.
+static const int PMWCAS_MAX_WORDS = 16;
+
+struct alignas(64) PMwCAS_Descriptor {
+    uint32_t count  = 0;
+    uint32_t status = 0;  // 0 = free, 1 = in use
+    PMwCAS_Entry entries[PMWCAS_MAX_WORDS];
+
+    void add(uint64_t *addr, uint64_t new_val) {
+        assert(count < PMWCAS_MAX_WORDS);
+        entries[count++] = { addr, new_val };
+    }
+};
+
+/* =========================================================
+   Per-thread descriptor pool
+   ========================================================= */
+// Descriptors are recycled from a fixed per-thread pool instead of being
+// built per insert. In persistent mode the pool stands for a PM region (as in
+// the PMwCAS paper), so returning a descriptor persists its status word; the
+// flush is ordered by the next operation's fence.
+static const int  DESC_POOL_SIZE = 64;
+static const bool DESC_POOL_IN_PM = true;
+
+class DescriptorPool {
+public:
+    DescriptorPool() {
+        for (int i = DESC_POOL_SIZE - 1; i >= 0; i--) free_idx[n_free++] = i;
+    }
+
+    PMwCAS_Descriptor &acquire() {
+        assert(n_free > 0);
+        PMwCAS_Descriptor &d = slots[free_idx[--n_free]];
+        d.count  = 0;
+        d.status = 1;
+        return d;
+    }
+
+    void release(PMwCAS_Descriptor &d, Stats &s) {
+        d.status = 0;
+        if (DESC_POOL_IN_PM) {
+            pcm_write(s);
+            pcm_flush(s);
+        }
+        free_idx[n_free++] = (int)(&d - slots);
+    }
+
+    static DescriptorPool &local() {
+        static thread_local DescriptorPool pool;
+        return pool;
+    }
+
+private:
+    PMwCAS_Descriptor slots[DESC_POOL_SIZE];
+    int free_idx[DESC_POOL_SIZE];
+    int n_free = 0;
 };
 
 bool pmwcas(PMwCAS_Descriptor &desc, Stats &s) {
@@ -39,19 +110,28 @@ bool pmwcas(PMwCAS_Descriptor &desc, Stats &s) {
        Here:
        - we simulate cost + atomicity
     */
-    // persist descriptor metadata
-    pcm_write(s, 2);
-    pcm_flush(s);
+    // persist descriptor: status word + (addr, new value) per entry
+    pcm_write(s, 1 + 2 * desc.count);
+    for (uintptr_t l = line_of(&desc); l <= line_of(&desc.entries[desc.count - 1].new_val); l++)
+        pcm_flush(s);
     pcm_fence(s);
 
     // apply all updates "atomically"
-    for (auto &e : desc.entries) {
+    for (uint32_t i = 0; i < desc.count; i++) {
+        auto &e = desc.entries[i];
         *(e.addr) = e.new_val;
         pcm_write(s);
     }
 
-    // persist final state
-    pcm_flush(s);
+    // persist final state: one flush per distinct target line
+    uintptr_t flushed[PMWCAS_MAX_WORDS];
+    size_t n_flushed = 0;
+    for (uint32_t i = 0; i < desc.count; i++) {
+        uintptr_t l = line_of(desc.entries[i].addr);
+        if (find(flushed, flushed + n_flushed, l) != flushed + n_flushed) continue;
+        flushed[n_flushed++] = l;
+        pcm_flush(s);
+    }
     pcm_fence(s);
     return true;
 }
@@ -61,34 +141,324 @@ bool pmwcas(PMwCAS_Descriptor &desc, Stats &s) {
    ========================================================= */
 static const int CAP = 32;
 
-struct LeafNode {
-    uint64_t keys[CAP];
-    int count = 0;
+// Header line first (count, status bitmap, version, sibling, sorted), keys
+// from the next line on; node padded to a multiple of 256 bytes. count is a
+// full word so PMwCAS can target it directly. keys[0..sorted) are in key
+// order (written by consolidation); inserts append unsorted after them.
+struct alignas(256) LeafNode {
+    alignas(LINE) uint64_t count = 0;
+    uint64_t bitmap = 0;
+    uint64_t version = 0;
+    LeafNode *sibling = nullptr;
+    uint64_t sorted = 0;
+    alignas(LINE) uint64_t keys[CAP];
 };
+static_assert(sizeof(LeafNode) % 256 == 0, "node size must be a multiple of 256 bytes");
 
 /* =========================================================
    Simplified BzTree Leaf Insert
    ========================================================= */
 void bztree_insert(LeafNode &leaf, uint64_t key, Stats &s) {
-    if (leaf.count >= CAP) return;
+    if (leaf.count >= (uint64_t)CAP) return;
 
-    PMwCAS_Descriptor d;
-    d.entries.push_back({ &leaf.keys[leaf.count], key });
-    d.entries.push_back({ (uint64_t*)&leaf.count,
-                          (uint64_t)(leaf.count + 1) });
+    DescriptorPool &pool = DescriptorPool::local();
+    PMwCAS_Descriptor &d = pool.acquire();
+    d.add(&leaf.keys[leaf.count], key);
+    d.add(&leaf.count, leaf.count + 1);
 
     pmwcas(d, s);
+    pool.release(d, s);
+}
+
+/* =========================================================
+   Consolidation (sort + split into two new nodes)
+   ========================================================= */
+// Copy-on-write as in BzTree: the live keys are sorted and written to two
+// new nodes (each header line and key line flushed, one fence), then the
+// parent pointer swings with one word write.
+void bztree_consolidate(const LeafNode &full, LeafNode &left, LeafNode &right, Stats &s) {
+    uint64_t k[CAP];
+    const int n = (int)full.count;
+    copy(full.keys, full.keys + n, k);
+    sort_small(k, n);
+
+    const int mid = n / 2;
+    copy(k, k + mid, left.keys);
+    copy(k + mid, k + n, right.keys);
+    left.count = left.sorted = mid;
+    right.count = right.sorted = n - mid;
+    left.bitmap = right.bitmap = 0;
+    left.version = right.version = full.version + 1;
+    right.sibling = full.sibling;
+    left.sibling = &right;
+    for (const LeafNode *node : { &left, &right }) {
+        pcm_write(s, 5 + node->count);
+        pcm_flush(s);
+        for (uint64_t i = 0; i < node->count; i += LINE / sizeof(uint64_t)) pcm_flush(s);
+    }
+    pcm_fence(s);
+
+    pcm_write(s); // parent pointer
+    pcm_flush(s);
+    pcm_fence(s);
+}
+
+/* =========================================================
+   Multi-key transactional insert
+   ========================================================= */
+struct InsertTarget {
+    LeafNode *leaf;
+    uint64_t  key;
+};
+
+// Groups targets by leaf: leaves[j] receives added[j] keys, and slot[i] is
+// target i's position within its leaf's batch. Returns the leaf count.
+static int group_targets(const InsertTarget *t, int n,
+                         LeafNode **leaves, uint64_t *added, int *slot) {
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        int j = 0;
+        while (j < m && leaves[j] != t[i].leaf) j++;
+        if (j == m) { leaves[m] = t[i].leaf; added[m++] = 0; }
+        slot[i] = (int)added[j]++;
+    }
+    return m;
+}
+
+// Inserts all n keys or none: every key slot and the count of every leaf
+// touched go into one PMwCAS descriptor. Fails (writing nothing) if the
+// keys plus one count per leaf exceed PMWCAS_MAX_WORDS, or if any leaf lacks
+// room for its share of the keys.
+bool bztree_multi_insert(const InsertTarget *t, int n, Stats &s) {
+    LeafNode *leaves[PMWCAS_MAX_WORDS];
+    uint64_t added[PMWCAS_MAX_WORDS];
+    int slot[PMWCAS_MAX_WORDS];
+    if (n > PMWCAS_MAX_WORDS) return false;
+    const int m = group_targets(t, n, leaves, added, slot);
+    if (n + m > PMWCAS_MAX_WORDS) return false;
+    for (int j = 0; j < m; j++)
+        if (leaves[j]->count + added[j] > (uint64_t)CAP) return false;
+
+    DescriptorPool &pool = DescriptorPool::local();
+    PMwCAS_Descriptor &d = pool.acquire();
+    for (int i = 0; i < n; i++)
+        d.add(&t[i].leaf->keys[t[i].leaf->count + slot[i]], t[i].key);
+    for (int j = 0; j < m; j++)
+        d.add(&leaves[j]->count, leaves[j]->count + added[j]);
+
+    pmwcas(d, s);
+    pool.release(d, s);
+    return true;
+}
+
+// Leaves without inner nodes: key -> leaf by hash partitioning.
+static const int NLEAVES = 64;
+
+struct LeafSet {
+    LeafNode leaves[NLEAVES];
+
+    LeafNode &route(uint64_t key) { return leaves[key % NLEAVES]; }
+};
+
+// multi_insert({k1, k2, ...}) on one leaf set. Same word budget as above.
+bool bztree_multi_insert(LeafSet &set, initializer_list<uint64_t> keys, Stats &s) {
+    if (keys.size() > (size_t)PMWCAS_MAX_WORDS) return false;
+    InsertTarget t[PMWCAS_MAX_WORDS];
+    int n = 0;
+    for (uint64_t k : keys) t[n++] = { &set.route(k), k };
+    return bztree_multi_insert(t, n, s);
+}
+
+// Redo-log transaction for comparison: log (addr, value) records for every
+// word, fence; persist the commit mark, fence; apply in place, flush the
+// touched lines, fence; clear the mark (ordered by the next fence).
+struct alignas(LINE) RedoLog {
+    uint64_t committed = 0;
+    alignas(LINE) uint64_t recs[2 * PMWCAS_MAX_WORDS];
+};
+
+bool redo_multi_insert(RedoLog &log, const InsertTarget *t, int n, Stats &s) {
+    LeafNode *leaves[PMWCAS_MAX_WORDS];
+    uint64_t added[PMWCAS_MAX_WORDS];
+    int slot[PMWCAS_MAX_WORDS];
+    if (n > PMWCAS_MAX_WORDS) return false;
+    const int m = group_targets(t, n, leaves, added, slot);
+    if (n + m > PMWCAS_MAX_WORDS) return false;
+    for (int j = 0; j < m; j++)
+        if (leaves[j]->count + added[j] > (uint64_t)CAP) return false;
+
+    PMwCAS_Entry words[PMWCAS_MAX_WORDS];
+    int w = 0;
+    for (int i = 0; i < n; i++)
+        words[w++] = { &t[i].leaf->keys[t[i].leaf->count + slot[i]], t[i].key };
+    for (int j = 0; j < m; j++)
+        words[w++] = { &leaves[j]->count, leaves[j]->count + added[j] };
+
+    for (int i = 0; i < w; i++) {
+        log.recs[2 * i]     = (uint64_t)words[i].addr;
+        log.recs[2 * i + 1] = words[i].new_val;
+    }
+    pcm_write(s, 2 * w);
+    for (uintptr_t l = line_of(&log.recs[0]); l <= line_of(&log.recs[2 * w - 1]); l++)
+        pcm_flush(s);
+    pcm_fence(s);
+
+    log.committed = 1;
+    pcm_write(s);
+    pcm_flush(s);
+    pcm_fence(s);
+
+    uintptr_t flushed[PMWCAS_MAX_WORDS];
+    size_t n_flushed = 0;
+    for (int i = 0; i < w; i++) {
+        *words[i].addr = words[i].new_val;
+        pcm_write(s);
+        uintptr_t l = line_of(words[i].addr);
+        if (find(flushed, flushed + n_flushed, l) != flushed + n_flushed) continue;
+        flushed[n_flushed++] = l;
+        pcm_flush(s);
+    }
+    pcm_fence(s);
+
+    log.committed = 0;
+    pcm_write(s);
+    pcm_flush(s);
+    return true;
 }
 
 /* =========================================================
    Search (no wear)
    ========================================================= */
 bool search_leaf(const LeafNode &leaf, uint64_t key) {
-    for (int i = 0; i < leaf.count; i++)
+    if (binary_search(leaf.keys, leaf.keys + leaf.sorted, key)) return true;
+    for (uint64_t i = leaf.sorted; i < leaf.count; i++)
         if (leaf.keys[i] == key) return true;
     return false;
 }
 
+/* =========================================================
+   Transaction benchmark
+   ========================================================= */
+enum class TxnMode { Sequential, PMwCAS, RedoLog };
+
+struct TxnResult {
+    double txn_per_sec;
+    Stats stats;
+    uint64_t allocs;
+};
+
+// Recycles (as if split off) any leaf that cannot take all n keys, so every
+// mode commits every transaction against identical leaf states.
+static void make_room(const InsertTarget *t, int n, Stats &s) {
+    for (int i = 0; i < n; i++) {
+        if (t[i].leaf->count + n > (uint64_t)CAP) {
+            t[i].leaf->count = 0;
+            pcm_write(s);
+            pcm_flush(s);
+            pcm_fence(s);
+        }
+    }
+}
+
+// `paired`: each transaction puts k into a primary set and its inverse into
+// a second set (keys_per_txn / 2 pairs). Otherwise keys_per_txn random keys
+// into one set.
+TxnResult run_txn_bench(TxnMode mode, int keys_per_txn, bool paired,
+                        const vector<uint64_t> &keys) {
+    static LeafSet primary, inverse;
+    primary = LeafSet();
+    inverse = LeafSet();
+    RedoLog log;
+    Stats s;
+
+    const int txns = (int)(keys.size() / keys_per_txn);
+    const uint64_t allocs0 = heap_allocs;
+    auto t0 = high_resolution_clock::now();
+    for (int x = 0; x < txns; x++) {
+        InsertTarget t[PMWCAS_MAX_WORDS];
+        const uint64_t *k = &keys[(size_t)x * keys_per_txn];
+        for (int i = 0; i < keys_per_txn; i++) {
+            if (paired && (i & 1)) {
+                uint64_t inv = ~k[i - 1];
+                t[i] = { &inverse.route(inv), inv };
+            } else {
+                t[i] = { &primary.route(k[i]), k[i] };
+            }
+        }
+        make_room(t, keys_per_txn, s);
+        switch (mode) {
+        case TxnMode::Sequential:
+            for (int i = 0; i < keys_per_txn; i++) bztree_insert(*t[i].leaf, t[i].key, s);
+            break;
+        case TxnMode::PMwCAS:
+            bztree_multi_insert(t, keys_per_txn, s);
+            break;
+        case TxnMode::RedoLog:
+            redo_multi_insert(log, t, keys_per_txn, s);
+            break;
+        }
+    }
+    auto t1 = high_resolution_clock::now();
+
+    TxnResult r;
+    r.txn_per_sec = txns / duration<double>(t1 - t0).count();
+    r.stats = s;
+    r.allocs = heap_allocs - allocs0;
+    return r;
+}
+
+/* =========================================================
+   Consolidation benchmark (insert tail latency)
+   ========================================================= */
+struct ConsolidationResult {
+    double p50_ns, p99_ns, p999_ns, consolidate_ns;
+    uint64_t consolidations;
+    Stats stats;
+    bool search_ok;
+};
+
+// Every key goes into one growing leaf; a full leaf is consolidated into two
+// new nodes and inserts continue on the left one. Nodes rotate through three
+// slots, so a consolidation never writes over its own source.
+ConsolidationResult run_consolidation_bench(SortKernel kernel, const vector<uint64_t> &keys) {
+    const SortKernel detected = sort_kernel;
+    sort_kernel = kernel;
+    static LeafNode nodes[3];
+    for (auto &n : nodes) n = LeafNode();
+    int cur = 0;
+    Stats s;
+    vector<uint32_t> lat(keys.size());
+    ConsolidationResult r{};
+    double consolidate_total = 0;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto t0 = steady_clock::now();
+        if (nodes[cur].count >= (uint64_t)CAP) {
+            const int l = (cur + 1) % 3, rt = (cur + 2) % 3;
+            bztree_consolidate(nodes[cur], nodes[l], nodes[rt], s);
+            cur = l;
+            r.consolidations++;
+            consolidate_total += duration<double, nano>(steady_clock::now() - t0).count();
+        }
+        bztree_insert(nodes[cur], keys[i], s);
+        lat[i] = (uint32_t)duration_cast<nanoseconds>(steady_clock::now() - t0).count();
+    }
+    // the live leaf: a sorted prefix, then every key inserted since its consolidation
+    const LeafNode &live = nodes[cur];
+    r.search_ok = is_sorted(live.keys, live.keys + live.sorted);
+    for (size_t i = keys.size() - (live.count - live.sorted); i < keys.size(); i++)
+        r.search_ok = r.search_ok && search_leaf(live, keys[i]);
+
+    sort(lat.begin(), lat.end());
+    r.p50_ns = lat[lat.size() / 2];
+    r.p99_ns = lat[lat.size() * 99 / 100];
+    r.p999_ns = lat[lat.size() * 999 / 1000];
+    r.consolidate_ns = r.consolidations ? consolidate_total / r.consolidations : 0;
+    r.stats = s;
+    sort_kernel = detected;
+    return r;
+}
+
 /* =========================================================
    Benchmark harness
    ========================================================= */
@@ -104,18 +474,21 @@ int main() {
     LeafNode leaf;
     Stats stats;
 
+    vector<uint64_t> ops(OPS);
+    for (auto &k : ops) k = dist(rng);
+
+    const uint64_t allocs0 = heap_allocs;
+
     // Prefill phase (matches paper setup)
     for (int i = 0; i < PREFILL; i++)
         bztree_insert(leaf, dist(rng), stats);
 
-    vector<uint64_t> ops(OPS);
-    for (auto &k : ops) k = dist(rng);
-
     // Insert benchmark
     auto t0 = high_resolution_clock::now();
     for (auto k : ops)
         bztree_insert(leaf, k, stats);
     auto t1 = high_resolution_clock::now();
+    const uint64_t insert_allocs = heap_allocs - allocs0;
 
     double secs = duration<double>(t1 - t0).count();
     double throughput = OPS / secs;
@@ -138,6 +511,76 @@ int main() {
 
     cout << "BzTree (PMwCAS) throughput: " << throughput << " ops/sec\n";
     cout << "Search hits: " << hits << " / 5000\n";
+    cout << "Heap allocations on the insert path: " << insert_allocs << "\n";
+
+    // Multi-key transactions: sequential single-key PMwCAS (not atomic) vs
+    // one multi-word PMwCAS vs a redo-log transaction
+    {
+        // sanity: all-or-none on a leaf that has room for only some keys
+        LeafSet probe;
+        probe.leaves[0].count = CAP - 1;
+        Stats ps;
+        bool ok = bztree_multi_insert(probe, { 0, NLEAVES, 1 }, ps);
+        cout << "multi_insert into a nearly full leaf: "
+             << (ok ? "committed" : "rejected") << ", leaf count "
+             << probe.leaves[0].count << ", leaf 1 count " << probe.leaves[1].count << "\n";
+
+        // sanity: over the word budget is rejected, not overrun. 17 keys, and
+        // 9 keys on 9 leaves (9 slots + 9 counts = 18 words)
+        LeafSet wide;
+        bool over = bztree_multi_insert(wide, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }, ps) ||
+                    bztree_multi_insert(wide, { 0, 1, 2, 3, 4, 5, 6, 7, 8 }, ps);
+        bool fits = bztree_multi_insert(wide, { 0, 1, 2, 3, 4, 5, 6, 7 }, ps);
+        uint64_t written = 0;
+        for (auto &l : wide.leaves) written += l.count;
+        cout << "multi_insert over the " << PMWCAS_MAX_WORDS << "-word budget: "
+             << (!over && fits && written == 8 ? "rejected" : "BROKEN") << "\n";
+
+        ofstream tcsv("results/bztree_multi_insert.csv");
+        tcsv << "variant,workload,keys_per_txn,txn_per_sec,Nw,Nclf,Nmf,heap_allocs\n";
+        struct { const char *name; int keys; bool paired; } loads[] = {
+            { "paired", 2, true }, { "batch", 4, false }, { "batch", 8, false },
+        };
+        struct { const char *name; TxnMode mode; } modes[] = {
+            { "sequential", TxnMode::Sequential },
+            { "pmwcas_multi", TxnMode::PMwCAS },
+            { "redo_log", TxnMode::RedoLog },
+        };
+        for (auto &l : loads) {
+            for (auto &m : modes) {
+                TxnResult r = run_txn_bench(m.mode, l.keys, l.paired, ops);
+                tcsv << m.name << "," << l.name << "," << l.keys << ","
+                     << r.txn_per_sec << ","
+                     << r.stats.Nw << "," << r.stats.Nclf << "," << r.stats.Nmf << ","
+                     << r.allocs << "\n";
+                cout << m.name << " " << l.name << "/" << l.keys << ": "
+                     << r.txn_per_sec << " txn/sec, Nw=" << r.stats.Nw
+                     << " Nclf=" << r.stats.Nclf << " Nmf=" << r.stats.Nmf << "\n";
+            }
+        }
+    }
+
+    // Consolidation: std::sort vs bitonic networks, as insert tail latency
+    {
+        ofstream ccsv("results/bztree_consolidation.csv");
+        ccsv << "kernel,inserts,consolidations,consolidate_ns,p50_ns,p99_ns,p999_ns,Nw,Nclf,Nmf\n";
+        struct { const char *name; SortKernel kernel; } kernels[] = {
+            { "std_sort", SortKernel::Std },
+            { "network_scalar", SortKernel::Scalar },
+            { "network_avx2", SortKernel::Avx2 },
+        };
+        for (auto &k : kernels) {
+            if (k.kernel == SortKernel::Avx2 && sort_kernel != SortKernel::Avx2) continue;
+            ConsolidationResult r = run_consolidation_bench(k.kernel, ops);
+            ccsv << k.name << "," << ops.size() << "," << r.consolidations << ","
+                 << r.consolidate_ns << "," << r.p50_ns << "," << r.p99_ns << "," << r.p999_ns << ","
+                 << r.stats.Nw << "," << r.stats.Nclf << "," << r.stats.Nmf << "\n";
+            cout << "Consolidation (" << k.name << "): " << r.consolidate_ns
+                 << " ns each, insert p50/p99/p99.9 " << r.p50_ns << "/" << r.p99_ns << "/"
+                 << r.p999_ns << " ns" << (r.search_ok ? "" : " (SEARCH FAILED)") << "\n";
+        }
+    }
+
     cout << " BzTree simulation complete\n";
 
     return 0;
@@ -0,0 +1,1119 @@
+// comparators_extension.cpp
+// Extension: comparator indexes run through the same mixed read/write driver
+// as the article sims, plus a multi-threaded variant of that driver.
+// Same fake persistence counters; this is a simulator, not a PM library.
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <stdexcept>
+
+#include "node_arena.h"
+
+struct Stats {
+    uint64_t Nw   = 0; // writes
+    uint64_t Nclf = 0; // cache line flushes
+    uint64_t Nmf  = 0; // memory fences
+
+    Stats& operator+=(const Stats& o) {
+        Nw += o.Nw; Nclf += o.Nclf; Nmf += o.Nmf;
+        return *this;
+    }
+};
+
+// One flush per cache line overlapping [p, p + bytes), by real address.
+inline void flush_lines(Stats& s, const void* p, size_t bytes) {
+    uintptr_t a = reinterpret_cast<uintptr_t>(p);
+    s.Nclf += (a + bytes - 1) / 64 - a / 64 + 1;
+}
+
+inline uint64_t mix_hash(uint64_t k) {
+    // splitmix64 finalizer
+    k ^= k >> 30; k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27; k *= 0x94d049bb133111ebULL;
+    return k ^ (k >> 31);
+}
+
+// ---------------------------------------------------------------------------
+// Baselines (same cost models as the article1/article3 extensions)
+// ---------------------------------------------------------------------------
+
+// Sorted insert at pos into n keys (n counted after the insert): keys[pos..n)
+// are rewritten, one word write each, one flush per touched line, one fence.
+// Same per-slot accounting as article1_extension's sorted leaves.
+inline void persist_shift(size_t pos, size_t n, Stats& s) {
+    s.Nw   += n - pos;
+    s.Nclf += (n + 7) / 8 - pos / 8;
+    s.Nmf  += 1;
+}
+
+struct SortedLeaf {
+    std::vector<uint64_t> keys;
+
+    void insert(uint64_t key, Stats& s) {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        const size_t pos = it - keys.begin();
+        keys.insert(it, key);
+        persist_shift(pos, keys.size(), s);
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        return it != keys.end() && *it == key;
+    }
+};
+
+// Flat PMwCAS cost per insert, as in article3_extension: a BzTree appends
+// into free space and sorts at consolidation, so no shift is charged.
+struct BzLeaf {
+    std::vector<uint64_t> keys;
+
+    void insert(uint64_t key, Stats& s) {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        keys.insert(it, key);
+        s.Nw   += 3;
+        s.Nclf += 3;
+        s.Nmf  += 2;
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        auto it = std::lower_bound(keys.begin(), keys.end(), key);
+        return it != keys.end() && *it == key;
+    }
+};
+
+// Single-threaded index behind one reader-writer lock, for the concurrent driver.
+template<typename Index>
+struct GlobalLock {
+    Index index;
+    mutable std::shared_mutex lock;
+
+    void insert(uint64_t key, Stats& s) {
+        std::unique_lock<std::shared_mutex> g(lock);
+        index.insert(key, s);
+    }
+
+    bool search(uint64_t key, Stats& s) const {
+        std::shared_lock<std::shared_mutex> g(lock);
+        return index.search(key, s);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// CCEH-style persistent extendible hash table
+// ---------------------------------------------------------------------------
+// Directory of 2^global_depth segment pointers indexed by the hash MSBs.
+// A segment is 256 cache-line buckets of 8 keys, indexed by the hash LSBs,
+// with linear probing over PROBE buckets. Inserts commit with one 8-byte
+// store + flush + fence. A full probe window splits only that segment: keys
+// whose next hash bit is 1 are copied to a new segment, and the copies left
+// behind are not erased -- they no longer match the old segment's pattern
+// and are reused as free slots (CCEH lazy deletion). The directory doubles
+// only when the splitting segment is already at global depth. Segment locks
+// are taken under a shared directory lock; splits hold it exclusively.
+class CCEH {
+public:
+    static const int BUCKETS = 256;
+    static const int SLOTS   = 8;   // 64-byte bucket
+    static const int PROBE   = 4;
+
+    explicit CCEH(int initial_depth = 2) : global_depth(initial_depth) {
+        for (uint64_t p = 0; p < (1ULL << initial_depth); ++p)
+            dir.push_back(std::make_shared<Segment>(initial_depth, p));
+    }
+
+    void insert(uint64_t key, Stats& s) {
+        const uint64_t h = mix_hash(key);
+        {
+            std::shared_lock<std::shared_mutex> d(dir_lock);
+            Segment& seg = *dir[dir_index(h)];
+            std::unique_lock<std::shared_mutex> g(seg.lock);
+            if (seg.try_insert(key, h, s)) return;
+        }
+        std::unique_lock<std::shared_mutex> d(dir_lock);
+        while (!dir[dir_index(h)]->try_insert(key, h, s))
+            split(dir[dir_index(h)], s);
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        const uint64_t h = mix_hash(key);
+        std::shared_lock<std::shared_mutex> d(dir_lock);
+        const Segment& seg = *dir[dir_index(h)];
+        std::shared_lock<std::shared_mutex> g(seg.lock);
+        return seg.find(key, h);
+    }
+
+    size_t segments() const {
+        std::shared_lock<std::shared_mutex> d(dir_lock);
+        std::vector<const Segment*> seen;
+        for (auto& p : dir) seen.push_back(p.get());
+        std::sort(seen.begin(), seen.end());
+        return std::unique(seen.begin(), seen.end()) - seen.begin();
+    }
+
+private:
+    struct Segment {
+        alignas(64) uint64_t b[BUCKETS][SLOTS] = {};
+        int local_depth;
+        uint64_t pattern; // hash MSBs this segment owns
+        mutable std::shared_mutex lock;
+
+        Segment(int depth, uint64_t pat) : local_depth(depth), pattern(pat) {}
+
+        bool owns(uint64_t h) const {
+            return local_depth == 0 || (h >> (64 - local_depth)) == pattern;
+        }
+
+        bool live(uint64_t k) const { return k != 0 && owns(mix_hash(k)); }
+
+        bool place(uint64_t key, uint64_t h) {
+            for (int p = 0; p < PROBE; ++p) {
+                uint64_t* bucket = b[(h + p) % BUCKETS];
+                for (int i = 0; i < SLOTS; ++i) {
+                    if (live(bucket[i])) continue;
+                    bucket[i] = key;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool try_insert(uint64_t key, uint64_t h, Stats& s) {
+            if (!place(key, h)) return false;
+            // 8-byte atomic commit of the key slot
+            s.Nw   += 1;
+            s.Nclf += 1;
+            s.Nmf  += 1;
+            return true;
+        }
+
+        bool find(uint64_t key, uint64_t h) const {
+            for (int p = 0; p < PROBE; ++p) {
+                const uint64_t* bucket = b[(h + p) % BUCKETS];
+                for (int i = 0; i < SLOTS; ++i)
+                    if (bucket[i] == key) return true;
+            }
+            return false;
+        }
+    };
+
+    std::vector<std::shared_ptr<Segment>> dir;
+    int global_depth;
+    mutable std::shared_mutex dir_lock;
+
+    size_t dir_index(uint64_t h) const { return h >> (64 - global_depth); }
+
+    // Caller holds dir_lock exclusively.
+    void split(std::shared_ptr<Segment> old, Stats& s) {
+        const int depth = old->local_depth + 1;
+        auto fresh = std::make_shared<Segment>(depth, (old->pattern << 1) | 1);
+
+        // 1) copy the keys that move into the new segment, persist it whole.
+        // Each key keeps its bucket and slot, which is inside its probe window,
+        // so the copy always fits; re-placing it with place() could fail.
+        for (int bi = 0; bi < BUCKETS; ++bi)
+            for (int si = 0; si < SLOTS; ++si) {
+                const uint64_t k = old->b[bi][si];
+                if (old->live(k) && fresh->owns(mix_hash(k))) {
+                    fresh->b[bi][si] = k;
+                    s.Nw += 1;
+                }
+            }
+        flush_lines(s, fresh->b, sizeof(fresh->b));
+        s.Nmf += 1;
+
+        // 2) double the directory if needed, persisting every entry
+        if (depth > global_depth) {
+            std::vector<std::shared_ptr<Segment>> bigger(dir.size() * 2);
+            for (size_t i = 0; i < bigger.size(); ++i) bigger[i] = dir[i >> 1];
+            dir.swap(bigger);
+            ++global_depth;
+            s.Nw += dir.size();
+            flush_lines(s, dir.data(), dir.size() * sizeof(dir[0]));
+            s.Nmf += 1;
+        }
+
+        // 3) point the upper half of the old range at the new segment
+        const int shift = global_depth - depth;
+        const size_t first = fresh->pattern << shift, n = size_t(1) << shift;
+        for (size_t i = first; i < first + n; ++i) dir[i] = fresh;
+        s.Nw += n;
+        flush_lines(s, &dir[first], n * sizeof(dir[0]));
+        s.Nmf += 1;
+
+        // 4) old segment's depth/pattern word: this retires the moved copies
+        old->local_depth = depth;
+        old->pattern <<= 1;
+        s.Nw   += 1;
+        s.Nclf += 1;
+        s.Nmf  += 1;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// WORT-style persistent radix tree
+// ---------------------------------------------------------------------------
+// Fixed 4-bit spans (16 children per node), as in WORT's write-optimal layout:
+// no key comparisons and no shifting. Keys below 2^63 are embedded in the
+// child slot as tagged words (key << 1 | 1), so a leaf insert is a single
+// 8-byte atomic store + flush + fence. Keys with bit 63 set do not fit that
+// tag; they go to an out-of-line leaf record (persisted before it is
+// published, as WORT does for values) whose pointer is tagged with 0b10. Each
+// node's header is one word packing its depth (nibble index it branches on)
+// and the absolute key prefix above it, so path compression never needs a
+// header rewrite: a new branch node is built and persisted off to the side,
+// then published with one 8-byte store into its parent. Single writer; the
+// concurrent driver wraps it in a lock.
+class RadixTree {
+public:
+    RadixTree() : root(nodes.alloc(0, 0)) {}
+    RadixTree(const RadixTree&) = delete;
+    RadixTree& operator=(const RadixTree&) = delete;
+
+    void insert(uint64_t key, Stats& s) {
+        Node* node = root;
+        for (;;) {
+            uintptr_t& slot = node->child[nibble(key, node->depth())];
+            if (slot == 0) {
+                commit(slot, leaf(key, s), s);
+                return;
+            }
+            uint64_t other;
+            if (is_leaf(slot)) {
+                other = leaf_key(slot);
+                if (other == key) return;
+            } else {
+                Node* child = as_node(slot);
+                if (child->matches(key)) { node = child; continue; }
+                other = child->prefix_key();
+            }
+            // branch where key and the existing subtree first differ
+            int d = __builtin_clzll(key ^ other) / 4;
+            Node* branch = nodes.alloc(d, key);
+            branch->child[nibble(other, d)] = slot;
+            branch->child[nibble(key, d)]   = leaf(key, s);
+            s.Nw += 3; // header + two child words
+            flush_lines(s, branch, sizeof(Node));
+            s.Nmf += 1;
+            commit(slot, reinterpret_cast<uintptr_t>(branch), s);
+            return;
+        }
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        const Node* node = root;
+        for (;;) {
+            uintptr_t slot = node->child[nibble(key, node->depth())];
+            if (slot == 0) return false;
+            if (is_leaf(slot)) return leaf_key(slot) == key;
+            node = as_node(slot);
+        }
+    }
+
+private:
+    struct alignas(64) Node {
+        uint64_t hdr;           // prefix << 4 | depth
+        uintptr_t child[16] = {};
+
+        Node(int depth, uint64_t key)
+            : hdr((depth == 0 ? 0 : (key >> (64 - 4 * depth)) << 4) | depth) {}
+
+        int depth() const { return hdr & 0xF; }
+        bool matches(uint64_t key) const {
+            return depth() == 0 || (key >> (64 - 4 * depth())) == (hdr >> 4);
+        }
+        // a key with this node's prefix, for nibble comparisons
+        uint64_t prefix_key() const {
+            return depth() == 0 ? 0 : (hdr >> 4) << (64 - 4 * depth());
+        }
+    };
+
+    struct alignas(8) LeafRecord { uint64_t key; };
+
+    // Nodes and leaf records live until the tree goes (insert-only).
+    NodeArena<Node> nodes;
+    NodeArena<LeafRecord> records;
+    Node* root;
+
+    static int nibble(uint64_t key, int depth) { return (key >> (60 - 4 * depth)) & 0xF; }
+
+    uintptr_t leaf(uint64_t key, Stats& s) {
+        if (!(key >> 63)) return (key << 1) | 1;
+        LeafRecord* r = records.alloc(LeafRecord{key});
+        s.Nw += 1;
+        flush_lines(s, r, sizeof(LeafRecord));
+        s.Nmf += 1;
+        return reinterpret_cast<uintptr_t>(r) | 2;
+    }
+    static bool is_leaf(uintptr_t w) { return w & 3; }
+    static bool is_record(uintptr_t w) { return (w & 3) == 2; }
+    static LeafRecord* as_record(uintptr_t w) { return reinterpret_cast<LeafRecord*>(w & ~uintptr_t(3)); }
+    static uint64_t leaf_key(uintptr_t w) { return is_record(w) ? as_record(w)->key : w >> 1; }
+    static Node* as_node(uintptr_t w) { return reinterpret_cast<Node*>(w); }
+
+    // 8-byte atomic commit: store, flush its line, fence
+    static void commit(uintptr_t& slot, uintptr_t value, Stats& s) {
+        slot = value;
+        s.Nw   += 1;
+        s.Nclf += 1;
+        s.Nmf  += 1;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Lock-free persistent skip list
+// ---------------------------------------------------------------------------
+// Only the bottom level is persistent: a node's key and level-0 next pointer
+// are written and flushed before it is linked, the level-0 CAS is the commit
+// point, and the updated link is flushed + fenced right after (flush-on-link).
+// Upper levels are volatile shortcuts linked with plain CAS afterwards and
+// are rebuilt from the bottom list by rebuild_towers() on recovery.
+// Insert-only (no deletes), so no marked pointers are needed.
+class SkipList {
+public:
+    static const int MAX_LEVEL = 16;
+
+    SkipList() : head(nodes.alloc(0, MAX_LEVEL)) {}
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+
+    void insert(uint64_t key, Stats& s) {
+        Node* preds[MAX_LEVEL];
+        Node* succs[MAX_LEVEL];
+        Node* node = nullptr;
+        for (;;) {
+            find(key, preds, succs);
+            if (succs[0] && succs[0]->key == key) { if (node) nodes.free(node); return; }
+            if (!node) node = nodes.alloc(key, random_height());
+            for (int i = 0; i < node->height; ++i)
+                node->next[i].store(succs[i], std::memory_order_relaxed);
+            // persist the node before it becomes reachable
+            s.Nw += 2; // key + level-0 next
+            flush_lines(s, node, sizeof(uint64_t) * 2);
+            s.Nmf += 1;
+            Node* expected = succs[0];
+            if (preds[0]->next[0].compare_exchange_strong(expected, node)) break;
+        }
+        // flush-on-link: the level-0 link is the durable commit
+        s.Nw   += 1;
+        s.Nclf += 1;
+        s.Nmf  += 1;
+
+        // volatile tower
+        for (int i = 1; i < node->height; ++i) {
+            for (;;) {
+                Node* expected = succs[i];
+                if (preds[i]->next[i].compare_exchange_strong(expected, node)) break;
+                find(key, preds, succs);
+                node->next[i].store(succs[i], std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        const Node* pred = head;
+        for (int i = MAX_LEVEL - 1; i >= 0; --i) {
+            const Node* cur = pred->next[i].load(std::memory_order_acquire);
+            while (cur && cur->key < key) {
+                pred = cur;
+                cur = cur->next[i].load(std::memory_order_acquire);
+            }
+            if (cur && cur->key == key) return true;
+        }
+        return false;
+    }
+
+    // Recovery: drop every upper-level link and relink from the persistent
+    // bottom list, keeping each node's height. Single-threaded.
+    size_t rebuild_towers() {
+        Node* last[MAX_LEVEL];
+        for (int i = 0; i < MAX_LEVEL; ++i) last[i] = head;
+        size_t n = 0;
+        for (Node* cur = head->next[0].load(); cur; cur = cur->next[0].load(), ++n) {
+            for (int i = 1; i < cur->height; ++i) {
+                last[i]->next[i].store(cur, std::memory_order_relaxed);
+                last[i] = cur;
+            }
+        }
+        for (int i = 1; i < MAX_LEVEL; ++i) last[i]->next[i].store(nullptr, std::memory_order_relaxed);
+        return n;
+    }
+
+    // Crash emulation: the volatile upper levels are lost, the bottom list
+    // and each node's height survive. Single-threaded.
+    void drop_towers() {
+        for (Node* cur = head; cur; cur = cur->next[0].load())
+            for (int i = 1; i < MAX_LEVEL; ++i) cur->next[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Nodes linked at each level, walking that level's own chain.
+    std::vector<size_t> level_counts() const {
+        std::vector<size_t> c(MAX_LEVEL, 0);
+        for (int i = 0; i < MAX_LEVEL; ++i)
+            for (const Node* cur = head->next[i].load(); cur; cur = cur->next[i].load()) ++c[i];
+        return c;
+    }
+
+private:
+    struct Node {
+        uint64_t key;                        // persistent
+        std::atomic<Node*> next[MAX_LEVEL];  // next[0] persistent, rest volatile
+        int height;
+
+        Node(uint64_t k, int h) : key(k), height(h) {
+            for (auto& p : next) p.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    NodeArena<Node> nodes; // towers included; freed with the list
+    Node* head;
+
+    static int random_height() {
+        static thread_local std::mt19937_64 rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        int h = 1 + __builtin_ctzll(rng() | (1ULL << (MAX_LEVEL - 1)));
+        return std::min(h, MAX_LEVEL);
+    }
+
+    void find(uint64_t key, Node** preds, Node** succs) const {
+        Node* pred = head;
+        for (int i = MAX_LEVEL - 1; i >= 0; --i) {
+            Node* cur = pred->next[i].load(std::memory_order_acquire);
+            while (cur && cur->key < key) {
+                pred = cur;
+                cur = cur->next[i].load(std::memory_order_acquire);
+            }
+            preds[i] = pred;
+            succs[i] = cur;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Log-structured (LSM) comparator: out-of-place writes
+// ---------------------------------------------------------------------------
+// Inserts go to a DRAM memtable and, for durability, one word appended to a
+// persistent log (write + flush + fence). A full memtable is written out as
+// an immutable sorted run with its Bloom filter (bulk write, one flush per
+// line, one fence) and the log is truncated. L0 holds up to L0_RUNS
+// overlapping runs; when full they are merged into L1, and any level past
+// its size budget (FANOUT x the previous one) is merged into the next
+// (leveled compaction). Lookups: memtable, then L0 newest first, then one
+// run per level, skipping runs whose Bloom filter rules the key out.
+class LSMTree {
+public:
+    static const size_t MEMTABLE = 4096;
+    static const size_t L0_RUNS  = 4;
+    static const size_t FANOUT   = 10;
+
+    void insert(uint64_t key, Stats& s) {
+        // durability: log append
+        s.Nw   += 1;
+        s.Nclf += 1;
+        s.Nmf  += 1;
+        memtable.insert(key);
+        if (memtable.size() >= MEMTABLE) flush_memtable(s);
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        if (memtable.count(key)) return true;
+        for (auto it = l0.rbegin(); it != l0.rend(); ++it)
+            if (it->contains(key)) return true;
+        for (auto& run : levels)
+            if (run.contains(key)) return true;
+        return false;
+    }
+
+private:
+    struct Bloom {
+        static const int BITS_PER_KEY = 10, HASHES = 7;
+        std::vector<uint64_t> bits;
+
+        explicit Bloom(size_t n = 0) : bits((n * BITS_PER_KEY + 63) / 64 + 1) {}
+
+        template<typename F> void probe(uint64_t key, F f) const {
+            uint64_t h = mix_hash(key), delta = (h >> 33) | 1;
+            const uint64_t m = bits.size() * 64;
+            for (int i = 0; i < HASHES; ++i, h += delta) f((h % m) / 64, 1ULL << (h % 64));
+        }
+        void add(uint64_t key) { probe(key, [&](size_t w, uint64_t b) { bits[w] |= b; }); }
+        bool may_contain(uint64_t key) const {
+            bool hit = true;
+            probe(key, [&](size_t w, uint64_t b) { hit = hit && (bits[w] & b); });
+            return hit;
+        }
+    };
+
+    struct Run {
+        std::vector<uint64_t> keys; // sorted, unique
+        Bloom bloom;
+
+        bool contains(uint64_t key) const {
+            if (keys.empty() || !bloom.may_contain(key)) return false;
+            return std::binary_search(keys.begin(), keys.end(), key);
+        }
+    };
+
+    std::set<uint64_t> memtable;
+    std::vector<Run> l0;      // oldest first
+    std::vector<Run> levels;  // levels[i] is L(i+1), one run each
+
+    // Write a run (keys + filter) to PM in one pass: one word per key and
+    // filter word, one flush per line, one fence.
+    static Run persist_run(std::vector<uint64_t>&& keys, Stats& s) {
+        Run r;
+        r.keys = std::move(keys);
+        r.bloom = Bloom(r.keys.size());
+        for (uint64_t k : r.keys) r.bloom.add(k);
+        s.Nw += r.keys.size() + r.bloom.bits.size();
+        if (!r.keys.empty()) flush_lines(s, r.keys.data(), r.keys.size() * sizeof(uint64_t));
+        flush_lines(s, r.bloom.bits.data(), r.bloom.bits.size() * sizeof(uint64_t));
+        s.Nmf += 1;
+        return r;
+    }
+
+    static std::vector<uint64_t> merge_unique(const std::vector<uint64_t>& a,
+                                              const std::vector<uint64_t>& b) {
+        std::vector<uint64_t> out;
+        out.reserve(a.size() + b.size());
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        return out;
+    }
+
+    void flush_memtable(Stats& s) {
+        l0.push_back(persist_run(std::vector<uint64_t>(memtable.begin(), memtable.end()), s));
+        memtable.clear();
+        // truncate the log: persist its new head
+        s.Nw   += 1;
+        s.Nclf += 1;
+        s.Nmf  += 1;
+        if (l0.size() >= L0_RUNS) compact(s);
+    }
+
+    void compact(Stats& s) {
+        std::vector<uint64_t> merged;
+        for (auto& r : l0) merged = merge_unique(merged, r.keys);
+        l0.clear();
+        size_t budget = MEMTABLE * L0_RUNS * FANOUT;
+        for (size_t lvl = 0; ; ++lvl, budget *= FANOUT) {
+            if (lvl == levels.size()) levels.emplace_back();
+            merged = merge_unique(merged, levels[lvl].keys);
+            if (merged.size() <= budget || lvl + 1 == 8) {
+                levels[lvl] = persist_run(std::move(merged), s);
+                return;
+            }
+            levels[lvl] = Run();   // spills whole into the next level
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Bw-tree comparator: latch-free delta updates over a mapping table
+// ---------------------------------------------------------------------------
+// Pages are addressed by PID through a mapping table of atomic pointers.
+// An insert prepends a delta record to the leaf's chain and installs it with
+// one CAS on the mapping entry. Persistence: the delta is flushed and fenced
+// before the CAS, then the mapping entry is flushed and fenced (write-ahead
+// of the pointer that publishes it). Once a chain reaches CHAIN_MAX deltas
+// the page is consolidated into a new base; a base over LEAF_MAX keys is
+// split B-link style (right half gets a new PID, left gets high_key +
+// sibling) and the separator is then posted to the root. The index layer is
+// a single root page (PID 0), replaced copy-on-write by CAS, which is enough
+// fanout at these sizes. Replaced chains are reclaimed through epochs.
+class BwTree {
+public:
+    static const int CHAIN_MAX = 8;
+    static const size_t LEAF_MAX = 256;
+    static const uint32_t MAP_CAP = 1u << 16;
+    static const uint32_t NONE = UINT32_MAX;
+
+    BwTree() : map(new std::atomic<Node*>[MAP_CAP]) {
+        for (uint32_t i = 0; i < MAP_CAP; ++i) map[i].store(nullptr, std::memory_order_relaxed);
+        Base* root = bases.alloc();
+        root->children.push_back(1);
+        map[0].store(root);
+        map[1].store(bases.alloc());
+    }
+
+    ~BwTree() {
+        for (uint32_t i = 0; i < next_pid.load(); ++i) free_chain(map[i].load());
+        for (auto& slot : epochs.slots)
+            for (auto& r : slot.limbo) free_chain(r.node);
+    }
+
+    BwTree(const BwTree&) = delete;
+    BwTree& operator=(const BwTree&) = delete;
+
+    void insert(uint64_t key, Stats& s) {
+        EpochGuard g(epochs);
+        for (;;) {
+            uint32_t pid;
+            Node* page = find_leaf(key, pid);
+            if (chain_contains(page, key)) return;
+
+            Node* d = deltas.alloc();
+            d->key = key;
+            d->next = page;
+            d->chain = page->chain + 1;
+            d->high_key = page->high_key;
+            d->sibling = page->sibling;
+            // delta record (key + next) durable before it is published
+            s.Nw   += 2;
+            s.Nclf += 1;
+            s.Nmf  += 1;
+
+            if (!map[pid].compare_exchange_strong(page, d)) {
+                deltas.free(d);
+                continue;
+            }
+            persist_entry(pid, s);
+            if (d->chain >= CHAIN_MAX) consolidate(pid, d, s);
+            return;
+        }
+    }
+
+    bool search(uint64_t key, Stats&) const {
+        EpochGuard g(epochs);
+        uint32_t pid;
+        return chain_contains(find_leaf(key, pid), key);
+    }
+
+    uint64_t consolidations() const { return n_consolidations.load(); }
+
+private:
+    // An insert delta (a fixed 40-byte record) or, with next == nullptr, a
+    // Base page under a delta chain. Leaf base: sorted keys. Root base:
+    // separators in keys, PIDs in children (child i covers
+    // [keys[i-1], keys[i])). Each kind has its own NodeArena, so a delta is
+    // a thread-cache pop with no vectors to build or tear down.
+    struct Node {
+        int chain = 0;                  // deltas from here down to the base
+        uint64_t key = 0;               // insert delta
+        Node* next = nullptr;
+        uint64_t high_key = UINT64_MAX; // keys >= high_key live at sibling
+        uint32_t sibling = NONE;
+    };
+    struct Base : Node {
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> children;
+    };
+
+    // Global epoch plus one announced epoch and limbo list per thread slot.
+    // A retired chain is freed once every active slot has moved past the
+    // epoch it was retired in.
+    struct Epochs {
+        static const int SLOTS = 64;
+        static const int SCAN_EVERY = 64;
+        struct Retired { Node* node; uint64_t epoch; };
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> active{0}; // 0 = quiescent
+            std::vector<Retired> limbo;
+        };
+
+        std::atomic<uint64_t> global{1};
+        Slot slots[SLOTS];
+
+        // Slot ids come from a process-wide bitmap of free slots: a thread
+        // claims the lowest free bit on first use and clears it when it
+        // exits, so two live threads never share a slot (and its limbo list).
+        static int self() {
+            static thread_local SlotClaim claim;
+            return claim.id;
+        }
+
+        struct SlotClaim {
+            int id;
+            SlotClaim() : id(claim_slot()) {}
+            ~SlotClaim() { used().fetch_and(~(1ULL << id)); }
+        };
+        static std::atomic<uint64_t>& used() {
+            static std::atomic<uint64_t> bits{0};
+            return bits;
+        }
+        static int claim_slot() {
+            static_assert(SLOTS == 64, "one bit per slot");
+            uint64_t cur = used().load();
+            for (;;) {
+                if (~cur == 0) throw std::runtime_error("BwTree: more live threads than epoch slots");
+                int id = __builtin_ctzll(~cur);
+                if (used().compare_exchange_weak(cur, cur | (1ULL << id))) return id;
+            }
+        }
+
+        BwTree& tree;
+        explicit Epochs(BwTree& t) : tree(t) {}
+
+        void retire(Node* n) {
+            Slot& me = slots[self()];
+            me.limbo.push_back({n, global.load()});
+            if (me.limbo.size() % SCAN_EVERY) return;
+            uint64_t safe = global.fetch_add(1) + 1;
+            for (auto& sl : slots) {
+                uint64_t a = sl.active.load();
+                if (a && a < safe) safe = a;
+            }
+            auto keep = std::partition(me.limbo.begin(), me.limbo.end(),
+                                       [&](const Retired& r) { return r.epoch >= safe; });
+            for (auto it = keep; it != me.limbo.end(); ++it) tree.free_chain(it->node);
+            me.limbo.erase(keep, me.limbo.end());
+        }
+    };
+
+    struct EpochGuard {
+        Epochs& e;
+        explicit EpochGuard(Epochs& ep) : e(ep) { e.slots[Epochs::self()].active.store(e.global.load()); }
+        ~EpochGuard() { e.slots[Epochs::self()].active.store(0); }
+    };
+
+    // declared first: they outlive every chain freed below
+    NodeArena<Node> deltas;
+    NodeArena<Base> bases;
+    std::unique_ptr<std::atomic<Node*>[]> map;
+    std::atomic<uint32_t> next_pid{2};
+    mutable Epochs epochs{*this};
+    std::atomic<uint64_t> n_consolidations{0};
+
+    void free_chain(Node* n) {
+        if (!n) return;
+        for (; n->next; ) {
+            Node* next = n->next;
+            deltas.free(n);
+            n = next;
+        }
+        bases.free(static_cast<Base*>(n));
+    }
+
+    static const Base* base_of(const Node* n) {
+        while (n->next) n = n->next;
+        return static_cast<const Base*>(n);
+    }
+
+    static bool chain_contains(const Node* n, uint64_t key) {
+        for (; n->next; n = n->next)
+            if (n->key == key) return true;
+        const Base* b = static_cast<const Base*>(n);
+        return std::binary_search(b->keys.begin(), b->keys.end(), key);
+    }
+
+    // PID 0 is always a base page (the root is replaced, never chained).
+    Node* find_leaf(uint64_t key, uint32_t& pid) const {
+        const Base* root = static_cast<const Base*>(map[0].load(std::memory_order_acquire));
+        size_t i = std::upper_bound(root->keys.begin(), root->keys.end(), key) - root->keys.begin();
+        pid = root->children[i];
+        Node* page = map[pid].load(std::memory_order_acquire);
+        // B-link: a split not yet posted to the root is reached via sibling
+        while (key >= page->high_key) {
+            pid = page->sibling;
+            page = map[pid].load(std::memory_order_acquire);
+        }
+        return page;
+    }
+
+    void persist_entry(uint32_t pid, Stats& s) {
+        s.Nw += 1;
+        flush_lines(s, &map[pid], sizeof(map[pid]));
+        s.Nmf += 1;
+    }
+
+    // New base page: header line + key (and child) array, one fence.
+    static void persist_base(const Base* n, Stats& s) {
+        s.Nw += 2 + n->keys.size() + (n->children.size() + 1) / 2;
+        s.Nclf += 1;
+        if (!n->keys.empty()) flush_lines(s, n->keys.data(), n->keys.size() * sizeof(uint64_t));
+        if (!n->children.empty()) flush_lines(s, n->children.data(), n->children.size() * sizeof(uint32_t));
+        s.Nmf += 1;
+    }
+
+    void consolidate(uint32_t pid, Node* page, Stats& s) {
+        const Base* base = base_of(page);
+        std::vector<uint64_t> added;
+        for (const Node* n = page; n->next; n = n->next) added.push_back(n->key);
+        std::sort(added.begin(), added.end());
+
+        Base* left = bases.alloc();
+        left->high_key = page->high_key;
+        left->sibling = page->sibling;
+        std::merge(base->keys.begin(), base->keys.end(), added.begin(), added.end(),
+                   std::back_inserter(left->keys));
+
+        Base* right = nullptr;
+        uint32_t right_pid = NONE;
+        if (left->keys.size() > LEAF_MAX) {
+            right_pid = next_pid.fetch_add(1);
+            if (right_pid >= MAP_CAP) throw std::runtime_error("BwTree: mapping table full");
+            const size_t mid = left->keys.size() / 2;
+            right = bases.alloc();
+            right->keys.assign(left->keys.begin() + mid, left->keys.end());
+            right->high_key = left->high_key;
+            right->sibling = left->sibling;
+            left->keys.resize(mid);
+            left->high_key = right->keys.front();
+            left->sibling = right_pid;
+            // right page is unreachable until the left CAS succeeds
+            map[right_pid].store(right);
+            persist_base(right, s);
+            persist_entry(right_pid, s);
+        }
+        persist_base(left, s);
+
+        if (!map[pid].compare_exchange_strong(page, left)) {
+            // lost to a concurrent update: the next insert will retry
+            bases.free(left);
+            if (right) {
+                map[right_pid].store(nullptr);
+                bases.free(right);
+            }
+            return;
+        }
+        persist_entry(pid, s);
+        epochs.retire(page);
+        n_consolidations.fetch_add(1, std::memory_order_relaxed);
+        if (right) post_separator(left->high_key, right_pid, s);
+    }
+
+    void post_separator(uint64_t sep, uint32_t child, Stats& s) {
+        for (;;) {
+            Node* root = map[0].load(std::memory_order_acquire);
+            Base* copy = bases.alloc(*static_cast<const Base*>(root));
+            size_t i = std::upper_bound(copy->keys.begin(), copy->keys.end(), sep) - copy->keys.begin();
+            copy->keys.insert(copy->keys.begin() + i, sep);
+            copy->children.insert(copy->children.begin() + i + 1, child);
+            persist_base(copy, s);
+            if (map[0].compare_exchange_strong(root, copy)) {
+                persist_entry(0, s);
+                epochs.retire(root);
+                return;
+            }
+            bases.free(copy);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Drivers
+// ---------------------------------------------------------------------------
+
+struct MixedResult {
+    double throughput_ops_sec;
+    Stats stats;
+    uint64_t search_hits;
+};
+
+template<typename IndexType>
+MixedResult run_mixed_workload(uint64_t prefill,
+                               uint64_t num_ops,
+                               double write_ratio) {
+    IndexType index;
+    Stats stats;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> dist_key(1, 1'000'000'000ULL);
+    std::uniform_real_distribution<double> dist01(0.0, 1.0);
+
+    for (uint64_t i = 0; i < prefill; ++i) {
+        index.insert(dist_key(rng), stats);
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    // hits are kept so the compiler cannot drop the (side-effect free) searches
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < num_ops; ++i) {
+        double r = dist01(rng);
+        uint64_t key = dist_key(rng);
+
+        if (r < write_ratio) {
+            index.insert(key, stats);
+        } else {
+            hits += index.search(key, stats);
+        }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = t1 - t0;
+
+    MixedResult res;
+    res.throughput_ops_sec = static_cast<double>(num_ops) / elapsed.count();
+    res.stats = stats;
+    res.search_hits = hits;
+    return res;
+}
+
+// Same workload split over `threads` threads sharing one index; each thread
+// has its own key stream and Stats, summed at the end.
+template<typename IndexType>
+MixedResult run_concurrent_workload(uint64_t prefill,
+                                    uint64_t num_ops,
+                                    double write_ratio,
+                                    int threads) {
+    IndexType index;
+    Stats prefill_stats;
+    {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<uint64_t> dist_key(1, 1'000'000'000ULL);
+        for (uint64_t i = 0; i < prefill; ++i) index.insert(dist_key(rng), prefill_stats);
+    }
+
+    std::vector<Stats> stats(threads);
+    std::vector<uint64_t> hits(threads, 0);
+    std::vector<std::thread> workers;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 rng(1000 + t);
+            std::uniform_int_distribution<uint64_t> dist_key(1, 1'000'000'000ULL);
+            std::uniform_real_distribution<double> dist01(0.0, 1.0);
+            for (uint64_t i = 0; i < num_ops / threads; ++i) {
+                double r = dist01(rng);
+                uint64_t key = dist_key(rng);
+                if (r < write_ratio) index.insert(key, stats[t]);
+                else                 hits[t] += index.search(key, stats[t]);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = t1 - t0;
+
+    MixedResult res;
+    res.throughput_ops_sec = static_cast<double>(num_ops / threads * threads) / elapsed.count();
+    res.stats = prefill_stats;
+    res.search_hits = 0;
+    for (int t = 0; t < threads; ++t) {
+        res.stats += stats[t];
+        res.search_hits += hits[t];
+    }
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// Self-checks (printed ahead of the CSV sections)
+// ---------------------------------------------------------------------------
+
+// Keys that differ only in bit 63 must stay distinct, and the extremes of the
+// key space must round-trip.
+bool check_radix_high_bits() {
+    RadixTree t;
+    Stats s;
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> in, out;
+    for (uint64_t k : {1ULL << 63, (1ULL << 63) - 1, ~0ULL, ~0ULL - 1}) in.push_back(k);
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t k = rng() & ~(1ULL << 63);
+        in.push_back(k | (1ULL << 63));
+        (i % 2 ? in : out).push_back(k); // half the low twins stay absent
+    }
+    for (uint64_t k : in) t.insert(k, s);
+    bool ok = true;
+    for (uint64_t k : in)  ok = ok && t.search(k, s);
+    for (uint64_t k : out) ok = ok && !t.search(k, s);
+    return ok;
+}
+
+// Grow a CCEH through many splits and check that every key survives them.
+bool check_cceh_splits() {
+    CCEH h;
+    Stats s;
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys(200000);
+    for (auto& k : keys) { k = rng() | 1; h.insert(k, s); }
+    bool ok = h.segments() > 100;
+    for (uint64_t k : keys) ok = ok && h.search(k, s);
+    return ok;
+}
+
+// Drop the volatile towers, rebuild them from the bottom list, and check that
+// every key is still found and every level links the same number of nodes.
+bool check_skiplist_recovery() {
+    SkipList l;
+    Stats s;
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys(20000);
+    for (auto& k : keys) { k = rng() % 1'000'000'000ULL + 1; l.insert(k, s); }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    const std::vector<size_t> before = l.level_counts();
+    l.drop_towers();
+    bool ok = l.level_counts()[1] == 0;
+    ok = ok && l.rebuild_towers() == keys.size();
+    ok = ok && l.level_counts() == before && before[0] == keys.size();
+    for (uint64_t k : keys) ok = ok && l.search(k, s);
+    return ok && !l.search(0, s);
+}
+
+void print_row(const char* variant, double wr, uint64_t ops, const MixedResult& r) {
+    std::cout << variant << ","
+              << wr << ","
+              << ops << ","
+              << r.throughput_ops_sec << ","
+              << r.stats.Nw << ","
+              << r.stats.Nclf << ","
+              << r.stats.Nmf << "\n";
+}
+
+void print_row(const char* variant, int threads, double wr, uint64_t ops, const MixedResult& r) {
+    std::cout << variant << ","
+              << threads << ","
+              << wr << ","
+              << ops << ","
+              << r.throughput_ops_sec << ","
+              << r.stats.Nw << ","
+              << r.stats.Nclf << ","
+              << r.stats.Nmf << "\n";
+}
+
+int main() {
+    const uint64_t PREFILL = 5000;
+    const uint64_t OPS     = 100000;
+
+    std::vector<double> write_ratios = {0.9, 0.5, 0.1, 0.0};
+
+    std::cout << "Radix tree keys with bit 63 set: " << (check_radix_high_bits() ? "ok" : "BROKEN") << "\n";
+    std::cout << "CCEH keys kept across splits: " << (check_cceh_splits() ? "ok" : "BROKEN") << "\n";
+    std::cout << "Skip list towers rebuilt after a crash: " << (check_skiplist_recovery() ? "ok" : "BROKEN") << "\n\n";
+
+    std::cout << "variant,write_ratio,ops,throughput_ops_sec,Nw,Nclf,Nmf\n";
+
+    for (double wr : write_ratios) {
+        print_row("sorted_leaf", wr, OPS, run_mixed_workload<SortedLeaf>(PREFILL, OPS, wr));
+        print_row("bztree_leaf", wr, OPS, run_mixed_workload<BzLeaf>(PREFILL, OPS, wr));
+        print_row("bwtree",      wr, OPS, run_mixed_workload<BwTree>(PREFILL, OPS, wr));
+        print_row("cceh",        wr, OPS, run_mixed_workload<CCEH>(PREFILL, OPS, wr));
+        print_row("radix_wort",  wr, OPS, run_mixed_workload<RadixTree>(PREFILL, OPS, wr));
+        print_row("skiplist",    wr, OPS, run_mixed_workload<SkipList>(PREFILL, OPS, wr));
+        print_row("lsm",         wr, OPS, run_mixed_workload<LSMTree>(PREFILL, OPS, wr));
+    }
+
+    std::cout << "\nvariant,threads,write_ratio,ops,throughput_ops_sec,Nw,Nclf,Nmf\n";
+
+    for (int threads : {1, 2, 4}) {
+        for (double wr : write_ratios) {
+            print_row("sorted_leaf_locked", threads, wr, OPS,
+                      run_concurrent_workload<GlobalLock<SortedLeaf>>(PREFILL, OPS, wr, threads));
+            print_row("bztree_leaf_locked", threads, wr, OPS,
+                      run_concurrent_workload<GlobalLock<BzLeaf>>(PREFILL, OPS, wr, threads));
+            print_row("bwtree", threads, wr, OPS,
+                      run_concurrent_workload<BwTree>(PREFILL, OPS, wr, threads));
+            print_row("cceh", threads, wr, OPS,
+                      run_concurrent_workload<CCEH>(PREFILL, OPS, wr, threads));
+            print_row("radix_wort_locked", threads, wr, OPS,
+                      run_concurrent_workload<GlobalLock<RadixTree>>(PREFILL, OPS, wr, threads));
+            print_row("skiplist", threads, wr, OPS,
+                      run_concurrent_workload<SkipList>(PREFILL, OPS, wr, threads));
+            print_row("lsm_locked", threads, wr, OPS,
+                      run_concurrent_workload<GlobalLock<LSMTree>>(PREFILL, OPS, wr, threads));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// node_arena.h
+// Node arena shared by the sims (mmap regions, huge pages when available).
+// Fixed-size, aligned nodes are carved from 64 MiB anonymous regions. Each
+// region asks for MAP_HUGETLB first and falls back to normal pages with a
+// transparent-huge-page hint. Threads allocate and free through their own
+// free list, refilled REFILL nodes at a time under the arena lock; reset()
+// drops every node at once (bulk reset between trials, no per-node frees).
+// Thread caches are keyed by a process-wide arena id plus the reset
+// generation, never by address: a new arena may be constructed where a
+// destroyed one lived, and must not inherit its (unmapped) free slots.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+inline std::atomic<uint64_t> next_arena_id{1};
+
+template<typename T>
+class NodeArena {
+public:
+    static const size_t REGION = 64 << 20;
+    static const size_t REFILL = 64;
+
+    NodeArena() = default;
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+    ~NodeArena() {
+        for (auto &r : regions) munmap(r.base, REGION);
+    }
+
+    template<typename... Args>
+    T *alloc(Args &&...args) {
+        ThreadCache &c = cache();
+        if (c.free.empty()) refill(c);
+        T *p = c.free.back();
+        c.free.pop_back();
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    void free(T *p) {
+        p->~T();
+        cache().free.push_back(p);
+    }
+
+    // Invalidate every node; memory stays mapped for the next trial.
+    void reset() {
+        std::lock_guard<std::mutex> g(lock);
+        for (auto &r : regions) r.used = 0;
+        cur = 0;
+        ++generation;
+    }
+
+    size_t huge_regions() const {
+        size_t n = 0;
+        for (auto &r : regions) n += r.huge;
+        return n;
+    }
+
+private:
+    static constexpr size_t SLOT = (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    struct Region { char *base; size_t used; bool huge; };
+    struct ThreadCache {
+        uint64_t owner = 0; // arena id
+        uint64_t gen = 0;
+        std::vector<T *> free;
+    };
+
+    const uint64_t id = next_arena_id.fetch_add(1, std::memory_order_relaxed);
+    std::vector<Region> regions;
+    size_t cur = 0;
+    std::atomic<uint64_t> generation{0};
+    std::mutex lock;
+
+    ThreadCache &cache() {
+        static thread_local ThreadCache c;
+        if (c.owner != id || c.gen != generation.load(std::memory_order_relaxed)) {
+            c.owner = id;
+            c.gen = generation.load(std::memory_order_relaxed);
+            c.free.clear();
+            c.free.reserve(REFILL);
+        }
+        return c;
+    }
+
+    void refill(ThreadCache &c) {
+        std::lock_guard<std::mutex> g(lock);
+        for (size_t n = 0; n < REFILL; n++) {
+            if (cur == regions.size()) regions.push_back(map_region());
+            Region &r = regions[cur];
+            if (r.used + SLOT > REGION) { cur++; n--; continue; }
+            c.free.push_back((T *)(r.base + r.used));
+            r.used += SLOT;
+        }
+        std::reverse(c.free.begin(), c.free.end()); // hand out ascending addresses
+    }
+
+    static Region map_region() {
+        void *p = mmap(nullptr, REGION, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        bool huge = p != MAP_FAILED;
+        if (!huge) {
+            p = mmap(nullptr, REGION, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) throw std::bad_alloc();
+            madvise(p, REGION, MADV_HUGEPAGE);
+        }
+        return Region{(char *)p, 0, huge};
+    }
+};
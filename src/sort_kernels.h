@@ -0,0 +1,263 @@
+// sort_kernels.h
+// Sorting kernels shared by the sims: bitonic sorting networks whose
+// compare-exchange schedule is generated at compile time per size (8 to 64
+// uint64_t keys), and a merge of sorted runs. Longer inputs sort 64-key
+// blocks and merge them pairwise. The AVX2 kernels carry a target attribute
+// and are picked at startup from CPUID, so a build without -mavx2 still uses
+// them and the binary still runs on CPUs without AVX2. Benchmarks switch
+// sort_kernel to compare against std::sort / std::merge.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+enum class SortKernel { Std, Scalar, Avx2 };
+
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define AVX2_DISPATCH 1
+#define AVX2_FN __attribute__((target("avx2")))
+inline bool cpu_has_avx2() {
+    static const bool has = [] { __builtin_cpu_init(); return (bool)__builtin_cpu_supports("avx2"); }();
+    return has;
+}
+#else
+inline bool cpu_has_avx2() { return false; }
+#endif
+
+inline SortKernel sort_kernel = cpu_has_avx2() ? SortKernel::Avx2 : SortKernel::Scalar;
+
+struct CmpEx { uint8_t lo, hi; }; // afterwards keys[lo] <= keys[hi]
+
+constexpr int ilog2(int n) { return n > 1 ? 1 + ilog2(n / 2) : 0; }
+
+// Batcher's bitonic sorter on N = 2^m keys: m(m+1)/2 stages of N/2 exchanges.
+template<int N>
+constexpr std::array<CmpEx, N / 2 * (ilog2(N) * (ilog2(N) + 1) / 2)> bitonic_pairs() {
+    static_assert(N >= 8 && N <= 64 && (N & (N - 1)) == 0, "network sizes are 8..64, powers of two");
+    std::array<CmpEx, N / 2 * (ilog2(N) * (ilog2(N) + 1) / 2)> p{};
+    int n = 0;
+    for (int k = 2; k <= N; k *= 2)
+        for (int j = k / 2; j > 0; j /= 2)
+            for (int i = 0; i < N; i++) {
+                const int l = i ^ j;
+                if (l < i) continue;
+                p[n++] = (i & k) ? CmpEx{(uint8_t)l, (uint8_t)i} : CmpEx{(uint8_t)i, (uint8_t)l};
+            }
+    return p;
+}
+
+template<int N>
+void bitonic_sort_scalar(uint64_t *v) {
+    static constexpr auto P = bitonic_pairs<N>();
+    for (auto c : P) { // branch-free: compiles to cmov pairs
+        const uint64_t a = v[c.lo], b = v[c.hi];
+        v[c.lo] = a < b ? a : b;
+        v[c.hi] = a < b ? b : a;
+    }
+}
+
+inline void merge_runs_scalar(const uint64_t *a, size_t na, const uint64_t *b, size_t nb, uint64_t *o) {
+    size_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        const bool ta = a[i] <= b[j];
+        *o++ = ta ? a[i] : b[j];
+        i += ta;
+        j += !ta;
+    }
+    o = std::copy(a + i, a + na, o);
+    std::copy(b + j, b + nb, o);
+}
+
+// One run much shorter than the other (b): binary-search each of its keys
+// in the long run and block-copy the stretch before it, instead of
+// comparing every key.
+inline void merge_runs_gallop(const uint64_t *a, size_t na, const uint64_t *b, size_t nb, uint64_t *o) {
+    const uint64_t *ap = a;
+    for (size_t j = 0; j < nb; j++) {
+        const uint64_t *p = std::upper_bound(ap, a + na, b[j]);
+        o = std::copy(ap, p, o);
+        *o++ = b[j];
+        ap = p;
+    }
+    std::copy(ap, a + na, o);
+}
+
+#ifdef AVX2_DISPATCH
+// Four keys per register, biased by the sign bit on load so that the signed
+// 64-bit compare orders them as unsigned.
+AVX2_FN inline __m256i load_biased(const uint64_t *p) {
+    return _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p), _mm256_set1_epi64x(INT64_MIN));
+}
+AVX2_FN inline void store_biased(uint64_t *p, __m256i v) {
+    _mm256_storeu_si256((__m256i *)p, _mm256_xor_si256(v, _mm256_set1_epi64x(INT64_MIN)));
+}
+AVX2_FN inline void minmax(__m256i &a, __m256i &b) {
+    const __m256i g = _mm256_cmpgt_epi64(a, b);
+    const __m256i lo = _mm256_blendv_epi8(a, b, g);
+    b = _mm256_blendv_epi8(b, a, g);
+    a = lo;
+}
+// In-register stage: lane p exchanges with lane p ^ j (j = 1 or 2) and keeps
+// the larger key where take_max is set.
+AVX2_FN inline __m256i lane_stage(__m256i v, int j, __m256i take_max) {
+    const __m256i sw = j == 2 ? _mm256_permute4x64_epi64(v, 0x4E) : _mm256_shuffle_epi32(v, 0x4E);
+    return _mm256_blendv_epi8(v, sw, _mm256_xor_si256(_mm256_cmpgt_epi64(v, sw), take_max));
+}
+
+// Same schedule as bitonic_pairs, on N/4 registers: exchanges 4 or more
+// apart are register min/max, the last two stages of each merge are lane
+// shuffles. The loops unroll fully, so every mask is a constant.
+template<int N>
+AVX2_FN void bitonic_sort_avx2(uint64_t *v) {
+    __m256i r[N / 4];
+#pragma GCC unroll 16
+    for (int q = 0; q < N / 4; q++) r[q] = load_biased(v + 4 * q);
+#pragma GCC unroll 8
+    for (int k = 2; k <= N; k *= 2) {
+#pragma GCC unroll 8
+        for (int j = k / 2; j > 0; j /= 2) {
+#pragma GCC unroll 16
+            for (int q = 0; q < N / 4; q++) {
+                if (j >= 4) {
+                    const int jv = j / 4;
+                    if (q & jv) continue;
+                    if ((4 * q) & k) minmax(r[q | jv], r[q]);
+                    else             minmax(r[q], r[q | jv]);
+                } else {
+                    long long m[4];
+                    for (int p = 0; p < 4; p++)
+                        m[p] = (((p & j) != 0) != (((4 * q + p) & k) != 0)) ? -1 : 0;
+                    r[q] = lane_stage(r[q], j, _mm256_set_epi64x(m[3], m[2], m[1], m[0]));
+                }
+            }
+        }
+    }
+#pragma GCC unroll 16
+    for (int q = 0; q < N / 4; q++) store_biased(v + 4 * q, r[q]);
+}
+
+// Merge two sorted registers: a gets the 4 smallest keys, b the 4 largest.
+AVX2_FN inline void merge4(__m256i &a, __m256i &b) {
+    b = _mm256_permute4x64_epi64(b, 0x1B);
+    minmax(a, b);
+    const __m256i up2 = _mm256_set_epi64x(-1, -1, 0, 0), up1 = _mm256_set_epi64x(-1, 0, -1, 0);
+    a = lane_stage(lane_stage(a, 2, up2), 1, up1);
+    b = lane_stage(lane_stage(b, 2, up2), 1, up1);
+}
+
+// One forward vector merge; `held` keeps the 4 largest keys of the last step.
+struct MergeCursor {
+    const uint64_t *a, *ae, *b, *be;
+    uint64_t *o;
+    __m256i held;
+    bool can_step() const { return a + 4 <= ae && b + 4 <= be; }
+};
+
+AVX2_FN inline void merge_step(MergeCursor &c) {
+    const bool ta = *c.a <= *c.b; // next block comes from the run with the smaller head
+    __m256i v = load_biased(ta ? c.a : c.b);
+    c.a += ta ? 4 : 0;
+    c.b += ta ? 0 : 4;
+    merge4(v, c.held);
+    store_biased(c.o, v);
+    c.o += 4;
+}
+
+AVX2_FN inline void merge_finish(MergeCursor &c) {
+    while (c.can_step()) merge_step(c);
+    uint64_t h[4];
+    store_biased(h, c.held);
+    const uint64_t *t = h, *te = h + 4;
+    while (t < te || c.a < c.ae || c.b < c.be) { // three-way scalar tail
+        const uint64_t x = t < te ? *t : UINT64_MAX;
+        const uint64_t y = c.a < c.ae ? *c.a : UINT64_MAX, z = c.b < c.be ? *c.b : UINT64_MAX;
+        if (t < te && x <= y && x <= z) *c.o++ = *t++;
+        else if (c.a < c.ae && y <= z)  *c.o++ = *c.a++;
+        else                            *c.o++ = *c.b++;
+    }
+}
+
+// A single vector merge is bound by the latency of merge4, so the output is
+// split at its midpoint (merge path) and both halves advance in lockstep.
+AVX2_FN inline void merge_runs_avx2(const uint64_t *a, size_t na, const uint64_t *b, size_t nb, uint64_t *o) {
+    const size_t half = (na + nb) / 2;
+    size_t lo = half > nb ? half - nb : 0, hi = std::min(half, na); // keys of a among the first half
+    while (lo < hi) {
+        const size_t i = (lo + hi) / 2;
+        if (b[half - i - 1] >= a[i]) lo = i + 1;
+        else                         hi = i;
+    }
+    MergeCursor c[2] = {{a, a + lo, b, b + (half - lo), o, {}},
+                        {a + lo, a + na, b + (half - lo), b + nb, o + half, {}}};
+    bool vec[2];
+    for (int h = 0; h < 2; h++) {
+        vec[h] = c[h].ae - c[h].a >= 4 && c[h].be - c[h].b >= 4;
+        if (!vec[h]) { merge_runs_scalar(c[h].a, c[h].ae - c[h].a, c[h].b, c[h].be - c[h].b, c[h].o); continue; }
+        c[h].held = load_biased(c[h].b);
+        c[h].b += 4;
+    }
+    if (vec[0] && vec[1])
+        while (c[0].can_step() && c[1].can_step()) { merge_step(c[0]); merge_step(c[1]); }
+    for (int h = 0; h < 2; h++)
+        if (vec[h]) merge_finish(c[h]);
+}
+#endif
+
+template<int N>
+void bitonic_sort(uint64_t *v) {
+#ifdef AVX2_DISPATCH
+    if (sort_kernel == SortKernel::Avx2) return bitonic_sort_avx2<N>(v);
+#endif
+    bitonic_sort_scalar<N>(v);
+}
+
+inline void merge_runs(const uint64_t *a, size_t na, const uint64_t *b, size_t nb, uint64_t *o) {
+    if (sort_kernel != SortKernel::Std && (na > 16 * nb || nb > 16 * na))
+        return na > nb ? merge_runs_gallop(a, na, b, nb, o) : merge_runs_gallop(b, nb, a, na, o);
+#ifdef AVX2_DISPATCH
+    if (sort_kernel == SortKernel::Avx2) return merge_runs_avx2(a, na, b, nb, o);
+#endif
+    if (sort_kernel == SortKernel::Std) std::merge(a, a + na, b, b + nb, o);
+    else                                merge_runs_scalar(a, na, b, nb, o);
+}
+
+// Up to 64 keys: pad to the next network size with UINT64_MAX. Longer
+// inputs (no network that wide) fall back to std::sort.
+inline void sort_small(uint64_t *v, size_t n) {
+    if (sort_kernel == SortKernel::Std || n > 64) { std::sort(v, v + n); return; }
+    const size_t w = n <= 8 ? 8 : n <= 16 ? 16 : n <= 32 ? 32 : 64;
+    uint64_t buf[64], *b = n == w ? v : buf;
+    if (b == buf) {
+        std::copy(v, v + n, buf);
+        std::fill(buf + n, buf + w, UINT64_MAX);
+    }
+    switch (w) {
+    case 8:  bitonic_sort<8>(b);  break;
+    case 16: bitonic_sort<16>(b); break;
+    case 32: bitonic_sort<32>(b); break;
+    default: bitonic_sort<64>(b); break;
+    }
+    if (b == buf) std::copy(buf, buf + n, v);
+}
+
+// Sort n keys in place; tmp has room for n keys.
+inline void sort_keys(uint64_t *v, size_t n, uint64_t *tmp) {
+    if (sort_kernel == SortKernel::Std) { std::sort(v, v + n); return; }
+    for (size_t i = 0; i < n; i += 64) sort_small(v + i, std::min<size_t>(64, n - i));
+    uint64_t *src = v, *dst = tmp;
+    for (size_t w = 64; w < n; w *= 2) {
+        for (size_t i = 0; i < n; i += 2 * w) {
+            const size_t m = std::min(i + w, n), e = std::min(i + 2 * w, n);
+            merge_runs(src + i, m - i, src + m, e - m, dst + i);
+        }
+        std::swap(src, dst);
+    }
+    if (src != v) std::copy(src, src + n, v);
+}